@@ -0,0 +1,210 @@
+//
+// BatchExecutor reduces many graph files on a bounded pipeline of loader and worker threads
+//
+
+#include "BatchExecutor.h"
+#include "BufferedWriter.h"
+#include "TransitiveReducer.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+/**
+ * blocks loaders while the estimated memory of the graphs in flight would exceed the budget
+ */
+class MemoryBudget {
+public:
+    explicit MemoryBudget(std::uint64_t budgetBytes) : budgetBytes(budgetBytes) {}
+
+    /**
+     * wait until bytes fit into the budget, or until nothing else is held so that oversized graphs still run
+     */
+    void acquire(std::uint64_t bytes) {
+        std::unique_lock lock(mutex);
+        released.wait(lock, [&] {
+            return usedBytes == 0 || usedBytes + bytes <= budgetBytes;
+        });
+        usedBytes += bytes;
+    }
+
+    void release(std::uint64_t bytes) {
+        {
+            std::lock_guard lock(mutex);
+            usedBytes -= bytes;
+        }
+        released.notify_all();
+    }
+
+private:
+    std::uint64_t budgetBytes;
+    std::uint64_t usedBytes = 0;
+    std::mutex mutex;
+    std::condition_variable released;
+};
+
+/**
+ * a parsed graph waiting for a worker, together with the memory it holds of the budget
+ */
+struct LoadedGraph {
+    std::string filePath;
+    FinalGraph finalGraph;
+    ReductionGraph graph;
+    std::uint64_t reservedBytes = 0;
+};
+
+/**
+ * queue from the loaders to the workers. pop returns nothing once all loaders are done and the queue is empty.
+ */
+class LoadedGraphQueue {
+public:
+    explicit LoadedGraphQueue(unsigned numberOfProducers) : numberOfProducers(numberOfProducers) {}
+
+    void push(LoadedGraph graph) {
+        {
+            std::lock_guard lock(mutex);
+            graphs.push_back(std::move(graph));
+        }
+        changed.notify_one();
+    }
+
+    void producerDone() {
+        {
+            std::lock_guard lock(mutex);
+            numberOfProducers--;
+        }
+        changed.notify_all();
+    }
+
+    std::optional<LoadedGraph> pop() {
+        std::unique_lock lock(mutex);
+        changed.wait(lock, [&] {
+            return !graphs.empty() || numberOfProducers == 0;
+        });
+        if (graphs.empty()) {
+            return std::nullopt;
+        }
+        LoadedGraph graph = std::move(graphs.front());
+        graphs.pop_front();
+        return graph;
+    }
+
+private:
+    unsigned numberOfProducers;
+    std::deque<LoadedGraph> graphs;
+    std::mutex mutex;
+    std::condition_variable changed;
+};
+
+std::uint64_t BatchExecutor::estimateMemory(std::uint64_t fileBytes) {
+    // a queued graph holds its FinalGraph and ReductionGraph, about 5 bytes per byte of the bundled txt graphs,
+    // plus the node id map while it is built. The indices live in the workspaces of the workers
+    return fileBytes * 8 + (std::uint64_t(64) << 10);
+}
+
+BatchResult BatchExecutor::run(const std::vector<std::string> &filePaths, const BatchConfig &config) {
+    auto start = std::chrono::steady_clock::now();
+    unsigned numberOfWorkers = config.numberOfWorkers > 0 ? config.numberOfWorkers
+                                                          : std::max(1u, std::thread::hardware_concurrency());
+    unsigned numberOfLoaders = std::max(1u, config.numberOfLoaders);
+
+    std::unique_ptr<BufferedWriter> writer;
+    if (!config.outputFilePath.empty()) {
+        writer = std::make_unique<BufferedWriter>(config.outputFilePath);
+    }
+    std::mutex writerMutex;
+    std::mutex errorMutex;
+    MemoryBudget budget(config.memoryBudgetBytes);
+    LoadedGraphQueue queue(numberOfLoaders);
+    std::atomic<std::size_t> nextFile{0};
+    std::atomic<std::uint64_t> graphs{0}, failedGraphs{0}, nodes{0}, edges{0}, redundantEdges{0};
+
+    auto reportFailure = [&](const std::string &filePath, const std::string &message) {
+        failedGraphs++;
+        std::lock_guard lock(errorMutex);
+        std::cerr << filePath << ": " << message << "\n";
+    };
+
+    auto load = [&] {
+        for (std::size_t i = nextFile++; i < filePaths.size(); i = nextFile++) {
+            const std::string &filePath = filePaths[i];
+            std::error_code error;
+            std::uintmax_t fileBytes = std::filesystem::file_size(filePath, error);
+            std::uint64_t reservedBytes = estimateMemory(error ? 0 : fileBytes);
+            budget.acquire(reservedBytes);
+            try {
+                FinalGraph finalGraph = GraphParser::importFinalGraph(filePath,
+                                                                      GraphParser::detectGraphFileFormat(filePath));
+                ReductionGraph graph(finalGraph.view());
+                queue.push({filePath, std::move(finalGraph), std::move(graph), reservedBytes});
+            } catch (const std::exception &exception) {
+                budget.release(reservedBytes);
+                reportFailure(filePath, exception.what());
+            }
+        }
+        queue.producerDone();
+    };
+
+    auto reduce = [&] {
+        // every worker reuses one workspace, so after the first graphs the reductions no longer allocate
+        ReductionWorkspace workspace;
+        TransitiveReducer reducer(ReductionOptions::forAlgorithm(config.algorithm));
+        while (std::optional<LoadedGraph> graph = queue.pop()) {
+            try {
+                reducer.reduce(graph->graph, workspace);
+                if (writer) {
+                    std::vector<std::uint64_t> redundancyBitmap = workspace.redundancyBitmap();
+                    std::lock_guard lock(writerMutex);
+                    if (config.outputFormat == GraphFileFormat::Binary) {
+                        std::uint64_t length = graph->filePath.size();
+                        writer->writeWords(&length, 1);
+                        writer->writeBytes(graph->filePath.data(), graph->filePath.size());
+                    } else {
+                        writer->writeBytes("# ", 2);
+                        writer->writeBytes(graph->filePath.data(), graph->filePath.size());
+                        writer->writeChar('\n');
+                    }
+                    GraphParser::writeReducedGraph(*writer, graph->finalGraph.view(), redundancyBitmap,
+                                                   config.outputFormat);
+                }
+                graphs++;
+                nodes += graph->graph.numberOfNodes();
+                edges += graph->graph.numberOfEdges();
+                redundantEdges += workspace.countRedundantEdges();
+            } catch (const std::exception &exception) {
+                reportFailure(graph->filePath, exception.what());
+            }
+            std::uint64_t reservedBytes = graph->reservedBytes;
+            graph.reset();
+            budget.release(reservedBytes);
+        }
+    };
+
+    std::vector<std::jthread> threads;
+    for (unsigned i = 0; i < numberOfLoaders; ++i) {
+        threads.emplace_back(load);
+    }
+    for (unsigned i = 0; i < numberOfWorkers; ++i) {
+        threads.emplace_back(reduce);
+    }
+    threads.clear();
+    if (writer) {
+        writer->close();
+    }
+
+    BatchResult result;
+    result.graphs = graphs;
+    result.failedGraphs = failedGraphs;
+    result.nodes = nodes;
+    result.edges = edges;
+    result.redundantEdges = redundantEdges;
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
@@ -0,0 +1,69 @@
+/**
+ * @file BatchExecutor.h
+ * @brief This file contains BatchExecutor, which reduces many graph files concurrently: loader threads prefetch and
+ * parse the next files while a worker pool reduces the parsed ones, bounded by a memory budget, and all reduced
+ * graphs stream into one combined output file.
+ */
+#ifndef ALGORITHMPROJECT_BATCHEXECUTOR_H
+#define ALGORITHMPROJECT_BATCHEXECUTOR_H
+
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "GraphParser.h"
+
+/**
+ * @brief settings of a batch run
+ */
+struct BatchConfig {
+    ReductionAlgorithm algorithm = ReductionAlgorithm::TROPlus;
+    // threads reducing parsed graphs, 0 uses all hardware threads
+    unsigned numberOfWorkers = 0;
+    // threads reading and parsing the next files ahead of the workers
+    unsigned numberOfLoaders = 1;
+    // upper bound of the estimated memory of all graphs that are loaded but not yet written. A graph larger
+    // than the budget is still processed, but only while no other graph is held
+    std::uint64_t memoryBudgetBytes = std::uint64_t(1) << 30;
+    // combined output of all reduced graphs, empty to only count redundant edges
+    std::string outputFilePath;
+    GraphFileFormat outputFormat = GraphFileFormat::Text;
+};
+
+/**
+ * @brief totals of a batch run
+ */
+struct BatchResult {
+    std::uint64_t graphs = 0;
+    // graphs that could not be read or reduced, reported on stderr and left out of the output
+    std::uint64_t failedGraphs = 0;
+    std::uint64_t nodes = 0;
+    std::uint64_t edges = 0;
+    std::uint64_t redundantEdges = 0;
+    double seconds = 0;
+
+    double graphsPerSecond() const {
+        return seconds > 0 ? static_cast<double>(graphs) / seconds : 0;
+    }
+};
+
+class BatchExecutor {
+public:
+    /**
+     * @brief reduce all given graph files.
+     *
+     * Reduced graphs are appended to the output in the order they finish. In the text format every graph is
+     * preceded by a line "# <input path>". In the binary format every graph is preceded by the 64-bit length of
+     * the input path and the path bytes, followed by the graph in the layout of GraphParser::exportFinalGraphBinary.
+     */
+    static BatchResult run(const std::vector<std::string> &filePaths, const BatchConfig &config);
+
+    /**
+     * @brief estimated memory of a parsed txt graph file of the given size while it waits for and is reduced by a
+     * worker, not counting the worker's reused workspace
+     */
+    static std::uint64_t estimateMemory(std::uint64_t fileBytes);
+};
+
+
+#endif //ALGORITHMPROJECT_BATCHEXECUTOR_H
@@ -0,0 +1,350 @@
+//
+// BitKernels runs the bit vector loops with the widest vector instructions the CPU supports
+//
+
+#include "BitKernels.h"
+#include <stdexcept>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define ALGORITHMPROJECT_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+
+/**
+ * the kernels of one level
+ */
+struct KernelTable {
+    void (*orInto)(std::uint64_t*, const std::uint64_t*, std::uint64_t);
+    bool (*isSubset)(const std::uint64_t*, const std::uint64_t*, std::uint64_t);
+    std::uint64_t (*popcount)(const std::uint64_t*, std::uint64_t);
+    std::uint64_t (*xorPopcount)(const std::uint64_t*, const std::uint64_t*, std::uint64_t);
+};
+
+static void orIntoScalar(std::uint64_t* target, const std::uint64_t* source, std::uint64_t words) {
+    for (std::uint64_t word = 0; word < words; ++word) {
+        target[word] |= source[word];
+    }
+}
+
+static bool isSubsetScalar(const std::uint64_t* a, const std::uint64_t* b, std::uint64_t words) {
+    for (std::uint64_t word = 0; word < words; ++word) {
+        if ((a[word] & ~b[word]) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static std::uint64_t popcountScalar(const std::uint64_t* a, std::uint64_t words) {
+    std::uint64_t count = 0;
+    for (std::uint64_t word = 0; word < words; ++word) {
+        count += std::popcount(a[word]);
+    }
+    return count;
+}
+
+static std::uint64_t xorPopcountScalar(const std::uint64_t* a, const std::uint64_t* b, std::uint64_t words) {
+    std::uint64_t count = 0;
+    for (std::uint64_t word = 0; word < words; ++word) {
+        count += std::popcount(a[word] ^ b[word]);
+    }
+    return count;
+}
+
+#ifdef ALGORITHMPROJECT_X86_KERNELS
+
+// SSE4.2: two words per vector, PTEST for the subset check and the POPCNT instruction, which comes with SSE4.2
+
+__attribute__((target("sse4.2,popcnt")))
+static void orIntoSSE42(std::uint64_t* target, const std::uint64_t* source, std::uint64_t words) {
+    std::uint64_t word = 0;
+    for (; word + 2 <= words; word += 2) {
+        __m128i value = _mm_or_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(target + word)),
+                                     _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + word)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(target + word), value);
+    }
+    for (; word < words; ++word) {
+        target[word] |= source[word];
+    }
+}
+
+__attribute__((target("sse4.2,popcnt")))
+static bool isSubsetSSE42(const std::uint64_t* a, const std::uint64_t* b, std::uint64_t words) {
+    std::uint64_t word = 0;
+    for (; word + 2 <= words; word += 2) {
+        // _mm_testc_si128(b, a) is set if a & ~b is zero
+        if (!_mm_testc_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(b + word)),
+                             _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + word)))) {
+            return false;
+        }
+    }
+    return word == words || (a[word] & ~b[word]) == 0;
+}
+
+__attribute__((target("sse4.2,popcnt")))
+static std::uint64_t popcountSSE42(const std::uint64_t* a, std::uint64_t words) {
+    std::uint64_t count = 0;
+    for (std::uint64_t word = 0; word < words; ++word) {
+        count += static_cast<std::uint64_t>(_mm_popcnt_u64(a[word]));
+    }
+    return count;
+}
+
+__attribute__((target("sse4.2,popcnt")))
+static std::uint64_t xorPopcountSSE42(const std::uint64_t* a, const std::uint64_t* b, std::uint64_t words) {
+    std::uint64_t count = 0;
+    for (std::uint64_t word = 0; word < words; ++word) {
+        count += static_cast<std::uint64_t>(_mm_popcnt_u64(a[word] ^ b[word]));
+    }
+    return count;
+}
+
+// AVX2: four words per vector. The population count looks up the count of each nibble with VPSHUFB and sums the
+// bytes of every word with VPSADBW, which beats one POPCNT per word on long vectors.
+
+__attribute__((target("avx2,popcnt")))
+static void orIntoAVX2(std::uint64_t* target, const std::uint64_t* source, std::uint64_t words) {
+    std::uint64_t word = 0;
+    for (; word + 4 <= words; word += 4) {
+        __m256i value = _mm256_or_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(target + word)),
+                                        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + word)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(target + word), value);
+    }
+    for (; word < words; ++word) {
+        target[word] |= source[word];
+    }
+}
+
+__attribute__((target("avx2,popcnt")))
+static bool isSubsetAVX2(const std::uint64_t* a, const std::uint64_t* b, std::uint64_t words) {
+    std::uint64_t word = 0;
+    for (; word + 4 <= words; word += 4) {
+        if (!_mm256_testc_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + word)),
+                                _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + word)))) {
+            return false;
+        }
+    }
+    for (; word < words; ++word) {
+        if ((a[word] & ~b[word]) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * the population count of each word of value
+ */
+__attribute__((target("avx2,popcnt")))
+static inline __m256i popcountWordsAVX2(__m256i value) {
+    const __m256i nibbleCounts = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                                  0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i lowNibbles = _mm256_set1_epi8(0x0f);
+    __m256i low = _mm256_shuffle_epi8(nibbleCounts, _mm256_and_si256(value, lowNibbles));
+    __m256i high = _mm256_shuffle_epi8(nibbleCounts, _mm256_and_si256(_mm256_srli_epi16(value, 4), lowNibbles));
+    return _mm256_sad_epu8(_mm256_add_epi8(low, high), _mm256_setzero_si256());
+}
+
+__attribute__((target("avx2,popcnt")))
+static std::uint64_t sumWordsAVX2(__m256i counts) {
+    __m128i sum = _mm_add_epi64(_mm256_castsi256_si128(counts), _mm256_extracti128_si256(counts, 1));
+    return static_cast<std::uint64_t>(_mm_cvtsi128_si64(sum)) + static_cast<std::uint64_t>(_mm_extract_epi64(sum, 1));
+}
+
+__attribute__((target("avx2,popcnt")))
+static std::uint64_t popcountAVX2(const std::uint64_t* a, std::uint64_t words) {
+    __m256i counts = _mm256_setzero_si256();
+    std::uint64_t word = 0;
+    for (; word + 4 <= words; word += 4) {
+        counts = _mm256_add_epi64(counts, popcountWordsAVX2(
+                _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + word))));
+    }
+    std::uint64_t count = sumWordsAVX2(counts);
+    for (; word < words; ++word) {
+        count += static_cast<std::uint64_t>(_mm_popcnt_u64(a[word]));
+    }
+    return count;
+}
+
+__attribute__((target("avx2,popcnt")))
+static std::uint64_t xorPopcountAVX2(const std::uint64_t* a, const std::uint64_t* b, std::uint64_t words) {
+    __m256i counts = _mm256_setzero_si256();
+    std::uint64_t word = 0;
+    for (; word + 4 <= words; word += 4) {
+        counts = _mm256_add_epi64(counts, popcountWordsAVX2(_mm256_xor_si256(
+                _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + word)),
+                _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + word)))));
+    }
+    std::uint64_t count = sumWordsAVX2(counts);
+    for (; word < words; ++word) {
+        count += static_cast<std::uint64_t>(_mm_popcnt_u64(a[word] ^ b[word]));
+    }
+    return count;
+}
+
+// AVX-512: eight words per vector, the last partial vector through masked loads and stores. The population count
+// is the nibble lookup of AVX2 on 512 bits, so that it does not need the VPOPCNTQ extension. Intrinsics that GCC
+// expands with an undefined pass-through register (broadcasts, extracts, the unmasked andnot and reduce) are avoided,
+// they raise -Wuninitialized under -Wall -Wextra.
+
+__attribute__((target("avx512f,avx512bw,popcnt")))
+static void orIntoAVX512(std::uint64_t* target, const std::uint64_t* source, std::uint64_t words) {
+    for (std::uint64_t word = 0; word < words; word += 8) {
+        __mmask8 mask = words - word >= 8 ? __mmask8(0xff) : static_cast<__mmask8>((1u << (words - word)) - 1);
+        __m512i value = _mm512_or_si512(_mm512_maskz_loadu_epi64(mask, target + word),
+                                        _mm512_maskz_loadu_epi64(mask, source + word));
+        _mm512_mask_storeu_epi64(target + word, mask, value);
+    }
+}
+
+__attribute__((target("avx512f,avx512bw,popcnt")))
+static bool isSubsetAVX512(const std::uint64_t* a, const std::uint64_t* b, std::uint64_t words) {
+    for (std::uint64_t word = 0; word < words; word += 8) {
+        __mmask8 mask = words - word >= 8 ? __mmask8(0xff) : static_cast<__mmask8>((1u << (words - word)) - 1);
+        __m512i outside = _mm512_maskz_andnot_epi64(mask, _mm512_maskz_loadu_epi64(mask, b + word),
+                                                    _mm512_maskz_loadu_epi64(mask, a + word));
+        if (_mm512_test_epi64_mask(outside, outside) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+__attribute__((target("avx512f,avx512bw,popcnt")))
+static inline __m512i popcountWordsAVX512(__m512i value) {
+    alignas(64) static constexpr std::uint8_t nibbleTable[64] = {
+            0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+            0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4};
+    const __m512i nibbleCounts = _mm512_load_si512(nibbleTable);
+    const __m512i lowNibbles = _mm512_set1_epi8(0x0f);
+    __m512i low = _mm512_shuffle_epi8(nibbleCounts, _mm512_and_si512(value, lowNibbles));
+    __m512i high = _mm512_shuffle_epi8(nibbleCounts, _mm512_and_si512(_mm512_srli_epi16(value, 4), lowNibbles));
+    return _mm512_sad_epu8(_mm512_add_epi8(low, high), _mm512_setzero_si512());
+}
+
+__attribute__((target("avx512f,avx512bw,popcnt")))
+static std::uint64_t sumWordsAVX512(__m512i counts) {
+    alignas(64) std::uint64_t lanes[8];
+    _mm512_store_si512(lanes, counts);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] + lanes[4] + lanes[5] + lanes[6] + lanes[7];
+}
+
+__attribute__((target("avx512f,avx512bw,popcnt")))
+static std::uint64_t popcountAVX512(const std::uint64_t* a, std::uint64_t words) {
+    __m512i counts = _mm512_setzero_si512();
+    for (std::uint64_t word = 0; word < words; word += 8) {
+        __mmask8 mask = words - word >= 8 ? __mmask8(0xff) : static_cast<__mmask8>((1u << (words - word)) - 1);
+        counts = _mm512_add_epi64(counts, popcountWordsAVX512(_mm512_maskz_loadu_epi64(mask, a + word)));
+    }
+    return sumWordsAVX512(counts);
+}
+
+__attribute__((target("avx512f,avx512bw,popcnt")))
+static std::uint64_t xorPopcountAVX512(const std::uint64_t* a, const std::uint64_t* b, std::uint64_t words) {
+    __m512i counts = _mm512_setzero_si512();
+    for (std::uint64_t word = 0; word < words; word += 8) {
+        __mmask8 mask = words - word >= 8 ? __mmask8(0xff) : static_cast<__mmask8>((1u << (words - word)) - 1);
+        counts = _mm512_add_epi64(counts, popcountWordsAVX512(_mm512_xor_si512(
+                _mm512_maskz_loadu_epi64(mask, a + word), _mm512_maskz_loadu_epi64(mask, b + word))));
+    }
+    return sumWordsAVX512(counts);
+}
+
+#endif
+
+static KernelTable tableFor(BitKernelLevel level) {
+    switch (level) {
+#ifdef ALGORITHMPROJECT_X86_KERNELS
+        case BitKernelLevel::SSE42:
+            return {orIntoSSE42, isSubsetSSE42, popcountSSE42, xorPopcountSSE42};
+        case BitKernelLevel::AVX2:
+            return {orIntoAVX2, isSubsetAVX2, popcountAVX2, xorPopcountAVX2};
+        case BitKernelLevel::AVX512:
+            return {orIntoAVX512, isSubsetAVX512, popcountAVX512, xorPopcountAVX512};
+#endif
+        default:
+            return {orIntoScalar, isSubsetScalar, popcountScalar, xorPopcountScalar};
+    }
+}
+
+/**
+ * the level and kernels in use, chosen on first use so that the CPU is queried after static initialization
+ */
+struct ActiveKernels {
+    BitKernelLevel level;
+    KernelTable table;
+};
+
+static ActiveKernels &activeKernels() {
+    static ActiveKernels active{BitKernels::bestLevel(), tableFor(BitKernels::bestLevel())};
+    return active;
+}
+
+BitKernelLevel BitKernels::bestLevel() {
+#ifdef ALGORITHMPROJECT_X86_KERNELS
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")) {
+        return BitKernelLevel::AVX512;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        return BitKernelLevel::AVX2;
+    }
+    if (__builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("popcnt")) {
+        return BitKernelLevel::SSE42;
+    }
+#endif
+    return BitKernelLevel::Scalar;
+}
+
+BitKernelLevel BitKernels::level() {
+    return activeKernels().level;
+}
+
+std::vector<BitKernelLevel> BitKernels::supportedLevels() {
+    std::vector<BitKernelLevel> levels;
+    for (BitKernelLevel level: {BitKernelLevel::Scalar, BitKernelLevel::SSE42, BitKernelLevel::AVX2,
+                                BitKernelLevel::AVX512}) {
+        if (level <= bestLevel()) {
+            levels.push_back(level);
+        }
+    }
+    return levels;
+}
+
+void BitKernels::setLevel(BitKernelLevel level) {
+    if (level > bestLevel()) {
+        throw std::runtime_error("The CPU does not support the " + levelName(level) + " bit kernels");
+    }
+    activeKernels() = {level, tableFor(level)};
+}
+
+std::string BitKernels::levelName(BitKernelLevel level) {
+    switch (level) {
+        case BitKernelLevel::Scalar:
+            return "scalar";
+        case BitKernelLevel::SSE42:
+            return "sse4.2";
+        case BitKernelLevel::AVX2:
+            return "avx2";
+        case BitKernelLevel::AVX512:
+            return "avx512";
+    }
+    return "";
+}
+
+void BitKernels::orIntoWide(std::uint64_t* target, const std::uint64_t* source, std::uint64_t words) {
+    activeKernels().table.orInto(target, source, words);
+}
+
+bool BitKernels::isSubsetWide(const std::uint64_t* a, const std::uint64_t* b, std::uint64_t words) {
+    return activeKernels().table.isSubset(a, b, words);
+}
+
+std::uint64_t BitKernels::popcountWide(const std::uint64_t* a, std::uint64_t words) {
+    return activeKernels().table.popcount(a, words);
+}
+
+std::uint64_t BitKernels::xorPopcountWide(const std::uint64_t* a, const std::uint64_t* b, std::uint64_t words) {
+    return activeKernels().table.xorPopcount(a, b, words);
+}
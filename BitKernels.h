@@ -0,0 +1,124 @@
+/**
+ * @file BitKernels.h
+ * @brief This file contains BitKernels, the word-parallel loops over bit vectors shared by the BFL labels, the
+ * closure bitsets of the Verifier and the redundancy bitmap comparisons, with scalar, SSE4.2, AVX2 and AVX-512
+ * implementations selected at runtime from the CPU features.
+ */
+#ifndef ALGORITHMPROJECT_BITKERNELS_H
+#define ALGORITHMPROJECT_BITKERNELS_H
+
+
+#include <bit>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief instruction set of the bit vector kernels, in increasing order of vector width
+ */
+enum class BitKernelLevel {
+    Scalar,
+    SSE42,
+    AVX2,
+    AVX512
+};
+
+class BitKernels {
+public:
+    /**
+     * @brief vectors of fewer words run the inline scalar loop, as the dispatched call costs more than the wide
+     * registers save on them. The default 160 BFL hash values fit in 3 words.
+     */
+    static constexpr std::uint64_t dispatchWords = 8;
+
+    /**
+     * @brief target[i] |= source[i] for i in [0, words)
+     */
+    static void orInto(std::uint64_t* target, const std::uint64_t* source, std::uint64_t words) {
+        if (words >= dispatchWords) {
+            orIntoWide(target, source, words);
+            return;
+        }
+        for (std::uint64_t word = 0; word < words; ++word) {
+            target[word] |= source[word];
+        }
+    }
+
+    /**
+     * @brief whether every bit of a is set in b, i.e. a & ~b is zero on all words
+     */
+    static bool isSubset(const std::uint64_t* a, const std::uint64_t* b, std::uint64_t words) {
+        if (words >= dispatchWords) {
+            return isSubsetWide(a, b, words);
+        }
+        for (std::uint64_t word = 0; word < words; ++word) {
+            if ((a[word] & ~b[word]) != 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief number of set bits in the words
+     */
+    static std::uint64_t popcount(const std::uint64_t* a, std::uint64_t words) {
+        if (words >= dispatchWords) {
+            return popcountWide(a, words);
+        }
+        std::uint64_t count = 0;
+        for (std::uint64_t word = 0; word < words; ++word) {
+            count += std::popcount(a[word]);
+        }
+        return count;
+    }
+
+    /**
+     * @brief number of bits that differ between a and b
+     */
+    static std::uint64_t xorPopcount(const std::uint64_t* a, const std::uint64_t* b, std::uint64_t words) {
+        if (words >= dispatchWords) {
+            return xorPopcountWide(a, b, words);
+        }
+        std::uint64_t count = 0;
+        for (std::uint64_t word = 0; word < words; ++word) {
+            count += std::popcount(a[word] ^ b[word]);
+        }
+        return count;
+    }
+
+    /**
+     * @brief the level the wide kernels run on, the best one the CPU supports unless setLevel chose another
+     */
+    static BitKernelLevel level();
+
+    /**
+     * @brief the best level the CPU and the compiler support
+     */
+    static BitKernelLevel bestLevel();
+
+    /**
+     * @brief all levels up to bestLevel, so that each can be compared with the scalar one
+     */
+    static std::vector<BitKernelLevel> supportedLevels();
+
+    /**
+     * @brief run the wide kernels on the given level, e.g. to time or check a narrower one. Throws if the CPU does
+     * not support it. Not thread-safe, call it before starting a reduction.
+     */
+    static void setLevel(BitKernelLevel level);
+
+    static std::string levelName(BitKernelLevel level);
+
+private:
+    static void orIntoWide(std::uint64_t* target, const std::uint64_t* source, std::uint64_t words);
+
+    static bool isSubsetWide(const std::uint64_t* a, const std::uint64_t* b, std::uint64_t words);
+
+    static std::uint64_t popcountWide(const std::uint64_t* a, std::uint64_t words);
+
+    static std::uint64_t xorPopcountWide(const std::uint64_t* a, const std::uint64_t* b, std::uint64_t words);
+};
+
+
+#endif //ALGORITHMPROJECT_BITKERNELS_H
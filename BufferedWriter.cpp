@@ -0,0 +1,245 @@
+//
+// BufferedWriter collects exported records in a large buffer and writes them with few system calls
+//
+
+#include "BufferedWriter.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#ifdef ALGORITHMPROJECT_HAVE_ZSTD
+#include <zstd.h>
+#endif
+#ifdef ALGORITHMPROJECT_HAVE_LZ4
+#include <lz4frame.h>
+#endif
+
+
+struct BufferedWriter::Compressor {
+#ifdef ALGORITHMPROJECT_HAVE_ZSTD
+    ZSTD_CCtx* zstdContext = nullptr;
+#endif
+#ifdef ALGORITHMPROJECT_HAVE_LZ4
+    LZ4F_cctx* lz4Context = nullptr;
+#endif
+    std::vector<char> output;
+
+    ~Compressor() {
+#ifdef ALGORITHMPROJECT_HAVE_ZSTD
+        ZSTD_freeCCtx(zstdContext);
+#endif
+#ifdef ALGORITHMPROJECT_HAVE_LZ4
+        LZ4F_freeCompressionContext(lz4Context);
+#endif
+    }
+};
+
+bool BufferedWriter::isCompressionAvailable(OutputCompression compression) {
+    switch (compression) {
+        case OutputCompression::None:
+            return true;
+        case OutputCompression::Zstd:
+#ifdef ALGORITHMPROJECT_HAVE_ZSTD
+            return true;
+#else
+            return false;
+#endif
+        case OutputCompression::Lz4:
+#ifdef ALGORITHMPROJECT_HAVE_LZ4
+            return true;
+#else
+            return false;
+#endif
+    }
+    return false;
+}
+
+BufferedWriter::BufferedWriter(const std::string &path, OutputCompression compression, std::size_t bufferSize)
+        : compression(compression), buffer(std::max<std::size_t>(bufferSize, 64)) {
+    if (!isCompressionAvailable(compression)) {
+        throw std::runtime_error("Compression requested for " + path + " is not available in this build");
+    }
+    descriptor = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (descriptor < 0) {
+        throw std::runtime_error("Cannot create " + path + ": " + std::strerror(errno));
+    }
+    current = buffer.data();
+    end = buffer.data() + buffer.size();
+
+    if (compression != OutputCompression::None) {
+        compressor = std::make_unique<Compressor>();
+    }
+#ifdef ALGORITHMPROJECT_HAVE_ZSTD
+    if (compression == OutputCompression::Zstd) {
+        compressor->zstdContext = ZSTD_createCCtx();
+        ZSTD_CCtx_setParameter(compressor->zstdContext, ZSTD_c_compressionLevel, 3);
+        compressor->output.resize(ZSTD_CStreamOutSize());
+    }
+#endif
+#ifdef ALGORITHMPROJECT_HAVE_LZ4
+    if (compression == OutputCompression::Lz4) {
+        if (LZ4F_isError(LZ4F_createCompressionContext(&compressor->lz4Context, LZ4F_VERSION))) {
+            throw std::runtime_error("Cannot create lz4 context for " + path);
+        }
+        compressor->output.resize(std::max<std::size_t>(LZ4F_compressBound(buffer.size(), nullptr),
+                                                        LZ4F_HEADER_SIZE_MAX));
+        std::size_t headerSize = LZ4F_compressBegin(compressor->lz4Context, compressor->output.data(),
+                                                    compressor->output.size(), nullptr);
+        if (LZ4F_isError(headerSize)) {
+            throw std::runtime_error("Cannot start lz4 frame for " + path);
+        }
+        writeToFile(compressor->output.data(), headerSize, nullptr, 0);
+    }
+#endif
+}
+
+BufferedWriter::~BufferedWriter() {
+    try {
+        close();
+    } catch (const std::exception &) {
+        // a destructor must not throw, callers that care about errors call close() themselves
+    }
+}
+
+void BufferedWriter::writeHex(std::uint64_t value, int width) {
+    if (end - current < 16 + width) {
+        flush();
+    }
+    char digits[16];
+    char* last = std::to_chars(digits, digits + sizeof(digits), value, 16).ptr;
+    for (long padding = width - (last - digits); padding > 0; --padding) {
+        *current++ = '0';
+    }
+    current = std::copy(digits, last, current);
+}
+
+void BufferedWriter::writeBytes(const void* data, std::size_t size) {
+    const char* bytes = static_cast<const char*>(data);
+    if (size <= static_cast<std::size_t>(end - current)) {
+        current = std::copy(bytes, bytes + size, current);
+        return;
+    }
+    if (compression != OutputCompression::None || size < buffer.size()) {
+        flush();
+        if (size < buffer.size()) {
+            current = std::copy(bytes, bytes + size, current);
+        } else {
+            compressToFile(bytes, size, false);
+        }
+        return;
+    }
+    // large uncompressed block: gather the buffered bytes and the block in one writev, no copy
+    writeToFile(buffer.data(), current - buffer.data(), bytes, size);
+    current = buffer.data();
+}
+
+void BufferedWriter::flush() {
+    if (current == buffer.data()) {
+        return;
+    }
+    if (compression == OutputCompression::None) {
+        writeToFile(buffer.data(), current - buffer.data(), nullptr, 0);
+    } else {
+        compressToFile(buffer.data(), current - buffer.data(), false);
+    }
+    current = buffer.data();
+}
+
+void BufferedWriter::close() {
+    if (descriptor < 0) {
+        return;
+    }
+    // the descriptor is closed on every path, a failed flush must not leave it open for the destructor to retry
+    try {
+        flush();
+        if (compression != OutputCompression::None) {
+            compressToFile(nullptr, 0, true);
+        }
+    } catch (...) {
+        ::close(descriptor);
+        descriptor = -1;
+        current = buffer.data();
+        throw;
+    }
+    int result = ::close(descriptor);
+    descriptor = -1;
+    if (result != 0) {
+        throw std::runtime_error(std::string("Cannot close exported file: ") + std::strerror(errno));
+    }
+}
+
+void BufferedWriter::writeToFile(const char* first, std::size_t firstSize, const char* second,
+                                 std::size_t secondSize) {
+    iovec blocks[2] = {{const_cast<char*>(first), firstSize}, {const_cast<char*>(second), secondSize}};
+    int numberOfBlocks = secondSize > 0 ? 2 : 1;
+    iovec* next = blocks;
+    while (numberOfBlocks > 0) {
+        ssize_t written = writev(descriptor, next, numberOfBlocks);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error(std::string("Write failed: ") + std::strerror(errno));
+        }
+        // skip the fully written blocks and advance into a partially written one
+        auto remaining = static_cast<std::size_t>(written);
+        while (numberOfBlocks > 0 && remaining >= next->iov_len) {
+            remaining -= next->iov_len;
+            next++;
+            numberOfBlocks--;
+        }
+        if (numberOfBlocks > 0) {
+            next->iov_base = static_cast<char*>(next->iov_base) + remaining;
+            next->iov_len -= remaining;
+        }
+    }
+}
+
+void BufferedWriter::compressToFile(const char* data, std::size_t size, bool finish) {
+#ifdef ALGORITHMPROJECT_HAVE_ZSTD
+    if (compression == OutputCompression::Zstd) {
+        ZSTD_inBuffer input{data, size, 0};
+        std::size_t remaining;
+        do {
+            ZSTD_outBuffer output{compressor->output.data(), compressor->output.size(), 0};
+            remaining = ZSTD_compressStream2(compressor->zstdContext, &output, &input,
+                                             finish ? ZSTD_e_end : ZSTD_e_continue);
+            if (ZSTD_isError(remaining)) {
+                throw std::runtime_error(std::string("zstd compression failed: ") + ZSTD_getErrorName(remaining));
+            }
+            writeToFile(compressor->output.data(), output.pos, nullptr, 0);
+        } while (finish ? remaining != 0 : input.pos < input.size);
+        return;
+    }
+#endif
+#ifdef ALGORITHMPROJECT_HAVE_LZ4
+    if (compression == OutputCompression::Lz4) {
+        // LZ4F_compressUpdate needs room for the worst case of its input, so feed it buffer sized pieces
+        for (std::size_t offset = 0; offset < size; offset += buffer.size()) {
+            std::size_t pieceSize = std::min(buffer.size(), size - offset);
+            std::size_t produced = LZ4F_compressUpdate(compressor->lz4Context, compressor->output.data(),
+                                                       compressor->output.size(), data + offset, pieceSize, nullptr);
+            if (LZ4F_isError(produced)) {
+                throw std::runtime_error(std::string("lz4 compression failed: ") + LZ4F_getErrorName(produced));
+            }
+            writeToFile(compressor->output.data(), produced, nullptr, 0);
+        }
+        if (finish) {
+            std::size_t produced = LZ4F_compressEnd(compressor->lz4Context, compressor->output.data(),
+                                                    compressor->output.size(), nullptr);
+            if (LZ4F_isError(produced)) {
+                throw std::runtime_error(std::string("lz4 compression failed: ") + LZ4F_getErrorName(produced));
+            }
+            writeToFile(compressor->output.data(), produced, nullptr, 0);
+        }
+        return;
+    }
+#endif
+    (void) data;
+    (void) size;
+    (void) finish;
+}
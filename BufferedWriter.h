@@ -0,0 +1,116 @@
+/**
+ * @file BufferedWriter.h
+ * @brief This file contains BufferedWriter, the output path for graph and result exports. It collects records in
+ * a large user-space buffer and hands them to the kernel in few large writes, optionally through zstd or lz4 framing.
+ */
+#ifndef ALGORITHMPROJECT_BUFFEREDWRITER_H
+#define ALGORITHMPROJECT_BUFFEREDWRITER_H
+
+
+#include <charconv>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @brief compression applied to an exported file. Zstd and Lz4 are only available when the library was found
+ * at build time, see BufferedWriter::isCompressionAvailable.
+ */
+enum class OutputCompression {
+    None,
+    Zstd,
+    Lz4
+};
+
+class BufferedWriter {
+public:
+    static constexpr std::size_t defaultBufferSize = std::size_t(4) << 20;
+
+    /**
+     * @brief create or truncate the file at path.
+     * Throws std::runtime_error if the file cannot be created or the compression is not available.
+     */
+    explicit BufferedWriter(const std::string &path, OutputCompression compression = OutputCompression::None,
+                            std::size_t bufferSize = defaultBufferSize);
+
+    BufferedWriter(const BufferedWriter &) = delete;
+
+    BufferedWriter &operator=(const BufferedWriter &) = delete;
+
+    /**
+     * @brief flush and close the file. Errors during the final flush are swallowed, call close() to see them.
+     */
+    ~BufferedWriter();
+
+    /**
+     * @brief append the decimal representation of value
+     */
+    void writeNumber(std::uint64_t value) {
+        if (end - current < 20) {
+            flush();
+        }
+        current = std::to_chars(current, end, value).ptr;
+    }
+
+    /**
+     * @brief append the hexadecimal representation of value, left padded with zeros to width digits
+     */
+    void writeHex(std::uint64_t value, int width);
+
+    void writeChar(char c) {
+        if (current == end) {
+            flush();
+        }
+        *current++ = c;
+    }
+
+    /**
+     * @brief append raw bytes. Blocks larger than the buffer are written together with the buffered bytes in a
+     * single writev call instead of being copied.
+     */
+    void writeBytes(const void* data, std::size_t size);
+
+    void writeWords(const std::uint64_t* words, std::size_t count) {
+        writeBytes(words, count * sizeof(std::uint64_t));
+    }
+
+    /**
+     * @brief flush the buffer, finish the compression frame and close the file. The file is closed even if the
+     *        flush throws, the first error is rethrown.
+     */
+    void close();
+
+    /**
+     * @brief whether this build can write the given compression
+     */
+    static bool isCompressionAvailable(OutputCompression compression);
+
+private:
+    int descriptor = -1;
+    OutputCompression compression;
+    std::vector<char> buffer;
+    char* current;
+    char* end;
+    // opaque compression context and output staging area, only used with compression
+    struct Compressor;
+    std::unique_ptr<Compressor> compressor;
+
+    /**
+     * @brief hand the buffered bytes to the compressor or the file
+     */
+    void flush();
+
+    /**
+     * @brief write all bytes of the given blocks to the file with as few writev calls as possible
+     */
+    void writeToFile(const char* first, std::size_t firstSize, const char* second, std::size_t secondSize);
+
+    /**
+     * @brief compress data and write the produced frame bytes. finish ends the frame.
+     */
+    void compressToFile(const char* data, std::size_t size, bool finish);
+};
+
+
+#endif //ALGORITHMPROJECT_BUFFEREDWRITER_H
@@ -0,0 +1,304 @@
+//
+// DifferentialTester checks all reduction engines against each other and the closure oracle on generated graphs
+//
+
+#include "DifferentialTester.h"
+#include "BitKernels.h"
+#include "ExternalReducer.h"
+#include "GraphParser.h"
+#include "TimeMeasurer.h"
+#include "TransitiveReducer.h"
+#include "Verifier.h"
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <tuple>
+#include <unistd.h>
+
+
+std::string DifferentialTester::checkGraph(const FinalGraph &graph) {
+    // one thread and several, so that the parallel DFS check and TRO+ schedule are compared with the serial ones
+    for (unsigned numberOfThreads: {1u, 3u}) {
+        CrossValidationConfig config;
+        config.numberOfThreads = numberOfThreads;
+        config.maxReportedMismatches = 1;
+        CrossValidationResult result = Verifier::crossValidate(graph, config);
+        if (!result.isValid()) {
+            const EdgeMismatch &mismatch = result.mismatches.front();
+            std::ostringstream failure;
+            failure << "edge " << mismatch.edgeId << " (" << mismatch.startNodeId << " -> " << mismatch.endNodeId
+                    << ") " << (mismatch.isRedundant ? "removed" : "kept") << " by " << mismatch.engine
+                    << ", not by " << mismatch.reference << " on " << numberOfThreads << " threads";
+            return failure.str();
+        }
+    }
+
+    ReductionGraph reductionGraph(graph.view());
+    ReductionWorkspace workspace;
+    TransitiveReducer(ReductionOptions::forAlgorithm(ReductionAlgorithm::TROPlus)).reduce(reductionGraph, workspace);
+    if (!TransitiveReducer::isTopologicalOrder(reductionGraph, workspace.topoOrder)) {
+        return "topoSort produced an order that is not topological";
+    }
+    // the 64-bit engine only runs on graphs beyond the 32-bit range, so compare it here
+    for (ReductionAlgorithm algorithm: {ReductionAlgorithm::DFS, ReductionAlgorithm::TROPlus}) {
+        WideReductionGraph wideGraph(graph.view());
+        WideReductionWorkspace wideWorkspace;
+        WideTransitiveReducer(ReductionOptions::forAlgorithm(algorithm)).reduce(wideGraph, wideWorkspace);
+        if (wideWorkspace.isRedundant != workspace.isRedundant) {
+            return "the 64-bit index engine differs from the 32-bit one";
+        }
+        if (!Verifier::certifyReduction(graph.view(), wideGraph, wideWorkspace, CertificateConfig()).isValid()) {
+            return "the workspace of the 64-bit index engine fails the reduction certificate";
+        }
+    }
+    // once with chunks of 64 nodes and searches that give up at once, which runs the chunked closure even on
+    // small graphs, and once with the defaults, where the searches settle every edge of a fuzzed graph. Both on
+    // the reduced graph and on the workspace, whose certificate reuses the engine's graph and topological order
+    FinalGraph reduced = Verifier::reducedGraph(graph, workspace.isRedundant);
+    CertificateConfig chunkedConfig;
+    chunkedConfig.numberOfThreads = 1;
+    chunkedConfig.maxMemoryBytes = 1;
+    chunkedConfig.maxSearchNodes = 0;
+    for (const CertificateConfig &config: {chunkedConfig, CertificateConfig()}) {
+        if (!Verifier::certifyReduction(graph, reduced, config).isValid()) {
+            return "the reduced graph of TRO+/BFL fails the reduction certificate";
+        }
+        if (!Verifier::certifyReduction(graph.view(), reductionGraph, workspace, config).isValid()) {
+            return "the workspace of TRO+/BFL fails the reduction certificate";
+        }
+    }
+
+    // the external reducer on files, with runs of 4 records so that even small graphs take several merge passes,
+    // and one 64 node chunk of sources per pass
+    std::filesystem::path workDirectory = std::filesystem::temp_directory_path()
+                                          / ("algorithm_project_differential_" + std::to_string(getpid()));
+    std::string inputPath = (workDirectory / "input.txt").string();
+    std::string outputPath = (workDirectory / "reduced.txt").string();
+    std::filesystem::create_directories(workDirectory);
+    ExternalReductionConfig externalConfig;
+    externalConfig.workDirectory = (workDirectory / "work").string();
+    externalConfig.memoryBudgetBytes = 0;
+    externalConfig.mergeBufferRecords = 4;
+    externalConfig.resume = false;
+    GraphParser::exportFinalGraph(graph.view(), inputPath);
+    ExternalReducer::reduceGraphFile(inputPath, outputPath, externalConfig);
+    FinalGraph externalReduced = GraphParser::importFinalGraph(outputPath);
+    std::filesystem::remove_all(workDirectory);
+    if (externalReduced.edgeIds != reduced.edgeIds) {
+        return "the external reducer keeps other edges than TRO+/BFL";
+    }
+    if (!Verifier::certifyReduction(graph, externalReduced, CertificateConfig()).isValid()) {
+        return "the reduced graph of the external reducer fails the reduction certificate";
+    }
+    return "";
+}
+
+FinalGraph DifferentialTester::decodeGraph(const std::uint8_t* data, std::size_t size) {
+    std::uint64_t numberOfNodes = size > 0 ? data[0] % 64 + 1 : 1;
+    // node index i gets id 2 * (numberOfNodes - i) + 1, so that ids run against the topological order
+    auto nodeId = [numberOfNodes](std::uint64_t node) {
+        return 2 * (numberOfNodes - node) + 1;
+    };
+    FinalGraph graph;
+    for (std::uint64_t node = 0; node < numberOfNodes; ++node) {
+        graph.addNode({nodeId(node)});
+    }
+    for (std::size_t i = 1; i + 1 < size; i += 2) {
+        std::uint64_t node1 = data[i] % numberOfNodes;
+        std::uint64_t node2 = data[i + 1] % numberOfNodes;
+        std::uint64_t startNode = std::min(node1, node2);
+        std::uint64_t endNode = std::max(node1, node2);
+        if (startNode == endNode) {
+            continue;
+        }
+        graph.addEdge({graph.numberOfEdges(), nodeId(startNode), nodeId(endNode)});
+    }
+    return graph;
+}
+
+std::string DifferentialTester::checkBitKernels(std::uint64_t seed) {
+    std::mt19937_64 generator(seed);
+    BitKernelLevel activeLevel = BitKernels::level();
+    std::string failure;
+    for (BitKernelLevel level: BitKernels::supportedLevels()) {
+        BitKernels::setLevel(level);
+        auto check = [&](bool isEqual, const std::string &kernel, std::uint64_t words) {
+            if (!isEqual && failure.empty()) {
+                failure = "the " + BitKernels::levelName(level) + " " + kernel
+                          + " kernel differs from the scalar loop on " + std::to_string(words) + " words";
+            }
+        };
+        for (std::uint64_t words = 0; words < 4 * BitKernels::dispatchWords && failure.empty(); ++words) {
+            // the vectors start one word into their storage, so that they are not aligned to a vector
+            std::vector<std::uint64_t> storageA(words + 1), storageB(words + 1), storageC(words + 1);
+            std::uint64_t* a = storageA.data() + 1;
+            std::uint64_t* b = storageB.data() + 1;
+            std::uint64_t* c = storageC.data() + 1;
+            std::uint64_t expectedCount = 0, expectedDifferences = 0;
+            for (std::uint64_t word = 0; word < words; ++word) {
+                a[word] = generator() & generator();
+                b[word] = a[word] | generator();
+                c[word] = generator();
+                expectedCount += std::popcount(a[word]);
+                expectedDifferences += std::popcount(a[word] ^ b[word]);
+            }
+            check(BitKernels::popcount(a, words) == expectedCount, "popcount", words);
+            check(BitKernels::xorPopcount(a, b, words) == expectedDifferences, "xorPopcount", words);
+            check(BitKernels::isSubset(a, b, words), "isSubset", words);
+            std::vector<std::uint64_t> expected(words);
+            for (std::uint64_t word = 0; word < words; ++word) {
+                expected[word] = b[word] | c[word];
+            }
+            BitKernels::orInto(b, c, words);
+            check(std::equal(expected.begin(), expected.end(), b), "orInto", words);
+            // a bit of c that is not in a makes c no subset of a
+            for (std::uint64_t word = words; word-- > 0;) {
+                if ((c[word] & ~a[word]) != 0) {
+                    check(!BitKernels::isSubset(c, a, words), "isSubset", words);
+                    break;
+                }
+            }
+        }
+    }
+    BitKernels::setLevel(activeLevel);
+    return failure;
+}
+
+DifferentialResult DifferentialTester::runRandomized(const DifferentialConfig &config) {
+    const GeneratorModel models[] = {GeneratorModel::ErdosRenyi, GeneratorModel::Layered, GeneratorModel::PowerLaw,
+                                     GeneratorModel::ChainHeavy, GeneratorModel::ClosureHeavy};
+    std::mt19937_64 generator(config.seed);
+    DifferentialResult result;
+    for (std::uint64_t iteration = 0; iteration < config.iterations; ++iteration) {
+        GeneratorConfig graphConfig;
+        graphConfig.model = models[generator() % std::size(models)];
+        graphConfig.numberOfNodes = 1 + generator() % std::max<std::uint64_t>(config.maxNodes, 1);
+        graphConfig.numberOfEdges = generator() % (graphConfig.numberOfNodes * config.maxAverageDegree + 1);
+        graphConfig.depth = 1 + generator() % graphConfig.numberOfNodes;
+        graphConfig.seed = generator();
+        graphConfig.numberOfThreads = 1;
+        FinalGraph graph = GraphGenerator::generate(graphConfig);
+        // the generators emit simple graphs, copies of random edges make it a multigraph
+        std::uint64_t generatedEdges = graph.numberOfEdges();
+        for (std::uint64_t copies = generator() % (generatedEdges / 8 + 1); copies > 0; --copies) {
+            FinalEdge edge = graph.view().edge(generator() % generatedEdges);
+            graph.addEdge({graph.numberOfEdges(), edge.startNodeId, edge.endNodeId});
+        }
+        result.graphs++;
+        result.edges += graph.numberOfEdges();
+        std::string failure = checkGraph(graph);
+        if (!failure.empty()) {
+            result.failure = failure;
+            result.failingConfig = graphConfig;
+            if (!config.failureFilePath.empty()) {
+                GraphParser::exportFinalGraph(graph, config.failureFilePath);
+            }
+            break;
+        }
+    }
+    return result;
+}
+
+std::string DifferentialTester::modelName(GeneratorModel model) {
+    switch (model) {
+        case GeneratorModel::ErdosRenyi:
+            return "er";
+        case GeneratorModel::Layered:
+            return "layered";
+        case GeneratorModel::PowerLaw:
+            return "powerlaw";
+        case GeneratorModel::ChainHeavy:
+            return "chain";
+        case GeneratorModel::ClosureHeavy:
+            return "closure";
+    }
+    return "";
+}
+
+std::vector<PerformanceSample> DifferentialTester::measurePerformance(const PerformanceConfig &config) {
+    std::vector<PerformanceSample> samples;
+    for (GeneratorModel model: config.models) {
+        for (std::uint64_t size: config.sizes) {
+            GeneratorConfig graphConfig;
+            graphConfig.model = model;
+            graphConfig.numberOfNodes = size;
+            graphConfig.numberOfEdges = size * config.averageDegree;
+            graphConfig.depth = config.depth;
+            graphConfig.seed = config.seed;
+            FinalGraph finalGraph = GraphGenerator::generate(graphConfig);
+            ReductionGraph graph(finalGraph.view());
+            ReductionWorkspace workspace;
+            for (const ReductionOptions &engine: CrossValidationConfig::defaultEngines()) {
+                TransitiveReducer reducer(engine);
+                // the first run sizes the workspace, the timed ones do not allocate
+                reducer.reduce(graph, workspace);
+                std::vector<double> durations;
+                for (unsigned run = 0; run < std::max(config.runs, 1u); ++run) {
+                    auto start = std::chrono::steady_clock::now();
+                    reducer.reduce(graph, workspace);
+                    durations.push_back(std::chrono::duration<double, std::nano>(
+                            std::chrono::steady_clock::now() - start).count());
+                }
+                PerformanceSample sample;
+                sample.family = modelName(model);
+                sample.numberOfNodes = graph.numberOfNodes();
+                sample.numberOfEdges = graph.numberOfEdges();
+                sample.engine = Verifier::engineName(engine);
+                sample.nanosecondsPerEdge = TimeMeasurer::summarize(sample.family, sample.engine, durations).median
+                                            / static_cast<double>(std::max<std::uint64_t>(graph.numberOfEdges(), 1));
+                samples.push_back(sample);
+            }
+        }
+    }
+    return samples;
+}
+
+void DifferentialTester::writePerformanceCsv(const std::string &filePath,
+                                             const std::vector<PerformanceSample> &samples) {
+    std::ofstream file(filePath);
+    file << "family,nodes,edges,engine,ns_per_edge\n";
+    for (const PerformanceSample &sample: samples) {
+        file << sample.family << ","
+             << sample.numberOfNodes << ","
+             << sample.numberOfEdges << ","
+             << sample.engine << ","
+             << sample.nanosecondsPerEdge << "\n";
+    }
+}
+
+std::vector<std::string> DifferentialTester::findRegressions(const std::vector<PerformanceSample> &samples,
+                                                             const std::string &baselineFilePath, double tolerance) {
+    std::ifstream file(baselineFilePath);
+    if (!file) {
+        throw std::runtime_error("Cannot open baseline file " + baselineFilePath);
+    }
+    // nanoseconds per edge by family, number of nodes and engine
+    std::map<std::tuple<std::string, std::uint64_t, std::string>, double> baseline;
+    std::string line;
+    std::getline(file, line);
+    while (std::getline(file, line)) {
+        std::istringstream row(line);
+        std::string family, nodes, edges, engine, nanosecondsPerEdge;
+        if (std::getline(row, family, ',') && std::getline(row, nodes, ',') && std::getline(row, edges, ',')
+            && std::getline(row, engine, ',') && std::getline(row, nanosecondsPerEdge)) {
+            baseline[{family, std::stoull(nodes), engine}] = std::stod(nanosecondsPerEdge);
+        }
+    }
+    std::vector<std::string> regressions;
+    for (const PerformanceSample &sample: samples) {
+        auto found = baseline.find({sample.family, sample.numberOfNodes, sample.engine});
+        if (found != baseline.end() && sample.nanosecondsPerEdge > found->second * (1 + tolerance)) {
+            std::ostringstream regression;
+            regression << sample.family << " " << sample.numberOfNodes << " nodes " << sample.engine << ": "
+                       << sample.nanosecondsPerEdge << " ns per edge, baseline " << found->second;
+            regressions.push_back(regression.str());
+        }
+    }
+    return regressions;
+}
@@ -0,0 +1,128 @@
+/**
+ * @file DifferentialTester.h
+ * @brief This file contains the differential tester, which runs every reduction engine on generated or fuzzed
+ * DAGs and checks their results against the closure oracle, and the performance regression run on generated graph
+ * families.
+ */
+#ifndef ALGORITHMPROJECT_DIFFERENTIALTESTER_H
+#define ALGORITHMPROJECT_DIFFERENTIALTESTER_H
+
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "FinalGraph.h"
+#include "GraphGenerator.h"
+
+/**
+ * @brief settings of DifferentialTester::runRandomized
+ */
+struct DifferentialConfig {
+    std::uint64_t iterations = 1000;
+    std::uint64_t seed = 1;
+    // generated graphs have 1 to maxNodes nodes and on average up to maxAverageDegree outgoing edges per node. More
+    // than 64 nodes take the external reducer several passes
+    std::uint64_t maxNodes = 128;
+    std::uint64_t maxAverageDegree = 6;
+    // the first failing graph is written here to reproduce it, nothing is written if empty
+    std::string failureFilePath;
+};
+
+/**
+ * @brief result of DifferentialTester::runRandomized, which stops at the first failing graph
+ */
+struct DifferentialResult {
+    std::uint64_t graphs = 0;
+    std::uint64_t edges = 0;
+    // what failed on the failing graph and how it was generated, empty if all graphs passed
+    std::string failure;
+    GeneratorConfig failingConfig;
+
+    bool isValid() const {
+        return failure.empty();
+    }
+};
+
+/**
+ * @brief settings of DifferentialTester::measurePerformance
+ */
+struct PerformanceConfig {
+    std::vector<GeneratorModel> models = {GeneratorModel::ErdosRenyi, GeneratorModel::Layered,
+                                          GeneratorModel::PowerLaw, GeneratorModel::ChainHeavy,
+                                          GeneratorModel::ClosureHeavy};
+    // DFS_RI stores the full closure, which grows quadratically on the er and closure families
+    std::vector<std::uint64_t> sizes = {1000, 4000};
+    std::uint64_t averageDegree = 5;
+    std::uint64_t depth = 50;
+    // timed reductions per graph and engine, the median is recorded
+    unsigned runs = 5;
+    std::uint64_t seed = 1;
+};
+
+/**
+ * @brief median reduction time of one engine on one generated graph
+ */
+struct PerformanceSample {
+    std::string family;
+    std::uint64_t numberOfNodes = 0;
+    std::uint64_t numberOfEdges = 0;
+    std::string engine;
+    double nanosecondsPerEdge = 0;
+};
+
+class DifferentialTester {
+public:
+    /**
+     * @brief run every engine with every index on one and on several threads, compare them with the closure oracle
+     * and certify the reduced graph, then run the external reducer with a tiny memory budget in a temporary
+     * directory and check that it keeps the same edges. Returns a description of the first failure, or an empty
+     * string.
+     */
+    static std::string checkGraph(const FinalGraph &graph);
+
+    /**
+     * @brief turn arbitrary fuzzer bytes into a small DAG: the first byte picks up to 64 nodes, every following
+     * pair of bytes an edge, which points from the smaller to the larger node index. Self loops are dropped, repeated
+     * pairs become parallel edges. Node ids are not in topological order.
+     */
+    static FinalGraph decodeGraph(const std::uint8_t* data, std::size_t size);
+
+    /**
+     * @brief compare the bit kernels of every level the CPU supports with scalar loops on random vectors of all
+     * lengths up to a few vectors, at an offset of one word. Returns a description of the first difference, or an
+     * empty string.
+     */
+    static std::string checkBitKernels(std::uint64_t seed);
+
+    /**
+     * @brief check config.iterations generated graphs of random models and sizes with checkGraph, with copies of
+     * some of their edges
+     */
+    static DifferentialResult runRandomized(const DifferentialConfig &config);
+
+    /**
+     * @brief time every engine on a generated graph of every model and size
+     */
+    static std::vector<PerformanceSample> measurePerformance(const PerformanceConfig &config);
+
+    /**
+     * @brief write samples as CSV, one row per graph and engine
+     */
+    static void writePerformanceCsv(const std::string &filePath, const std::vector<PerformanceSample> &samples);
+
+    /**
+     * @brief compare samples with a CSV written by writePerformanceCsv. Returns a line for every sample that is
+     * more than tolerance (a fraction) slower per edge than the baseline sample of the same family, size and engine.
+     */
+    static std::vector<std::string> findRegressions(const std::vector<PerformanceSample> &samples,
+                                                    const std::string &baselineFilePath, double tolerance);
+
+    /**
+     * @brief the name of a model as accepted by GraphGenerator::parseModel
+     */
+    static std::string modelName(GeneratorModel model);
+};
+
+
+#endif //ALGORITHMPROJECT_DIFFERENTIALTESTER_H
@@ -0,0 +1,592 @@
+//
+// ExternalReducer computes the transitive reduction of graphs larger than memory with external sorting and
+// chunked reachability passes over memory-mapped edge files
+//
+
+#include "ExternalReducer.h"
+#include "GraphParser.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <queue>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+/**
+ * read-only memory mapping of a whole file, unmapped when it goes out of scope
+ */
+class MappedFile {
+public:
+    explicit MappedFile(const std::string &path) {
+        int descriptor = open(path.c_str(), O_RDONLY);
+        if (descriptor < 0) {
+            throw std::runtime_error("Cannot open " + path);
+        }
+        struct stat status{};
+        if (fstat(descriptor, &status) != 0) {
+            close(descriptor);
+            throw std::runtime_error("Cannot stat " + path);
+        }
+        length = static_cast<std::size_t>(status.st_size);
+        if (length > 0) {
+            data = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, descriptor, 0);
+            if (data == MAP_FAILED) {
+                close(descriptor);
+                throw std::runtime_error("Cannot map " + path);
+            }
+            madvise(data, length, MADV_SEQUENTIAL);
+        }
+        close(descriptor);
+    }
+
+    MappedFile(const MappedFile &) = delete;
+
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    ~MappedFile() {
+        if (data != nullptr) {
+            munmap(data, length);
+        }
+    }
+
+    const ExternalEdgeRecord* records() const {
+        return static_cast<const ExternalEdgeRecord*>(data);
+    }
+
+    std::uint64_t numberOfRecords() const {
+        return length / sizeof(ExternalEdgeRecord);
+    }
+
+private:
+    void* data = nullptr;
+    std::size_t length = 0;
+};
+
+/**
+ * throw if a write to file failed, e.g. on a full disk, before a later stage relies on its content
+ */
+static void requireWritten(std::ostream &file, const std::string &path) {
+    if (!file.flush()) {
+        throw std::runtime_error("Cannot write " + path);
+    }
+}
+
+/**
+ * appends ExternalEdgeRecords to a binary file through a fixed size buffer. close() reports write errors, the
+ * destructor only flushes what is left.
+ */
+class RecordWriter {
+public:
+    explicit RecordWriter(const std::string &path) : path(path), file(path, std::ios::binary | std::ios::trunc) {
+        if (!file) {
+            throw std::runtime_error("Cannot create " + path);
+        }
+        buffer.reserve(bufferSize);
+    }
+
+    void write(const ExternalEdgeRecord &record) {
+        buffer.push_back(record);
+        if (buffer.size() == bufferSize) {
+            flush();
+        }
+    }
+
+    void flush() {
+        file.write(reinterpret_cast<const char*>(buffer.data()),
+                   static_cast<std::streamsize>(buffer.size() * sizeof(ExternalEdgeRecord)));
+        buffer.clear();
+    }
+
+    void close() {
+        flush();
+        requireWritten(file, path);
+        file.close();
+    }
+
+    ~RecordWriter() {
+        if (file.is_open()) {
+            flush();
+        }
+    }
+
+private:
+    static constexpr std::size_t bufferSize = 1 << 16;
+    std::string path;
+    std::ofstream file;
+    std::vector<ExternalEdgeRecord> buffer;
+};
+
+static bool recordLess(const ExternalEdgeRecord &a, const ExternalEdgeRecord &b) {
+    if (a.startNode != b.startNode)
+        return a.startNode < b.startNode;
+    if (a.endNode != b.endNode)
+        return a.endNode < b.endNode;
+    return a.position < b.position;
+}
+
+/**
+ * sequential reader of one sorted run during the k-way merge
+ */
+struct RunReader {
+    std::ifstream file;
+    std::vector<ExternalEdgeRecord> buffer;
+    std::size_t bufferRecords;
+    std::size_t next = 0;
+
+    RunReader(const std::string &path, std::size_t bufferRecords)
+            : file(path, std::ios::binary), bufferRecords(bufferRecords) {
+        refill();
+    }
+
+    void refill() {
+        buffer.resize(bufferRecords);
+        file.read(reinterpret_cast<char*>(buffer.data()),
+                  static_cast<std::streamsize>(bufferRecords * sizeof(ExternalEdgeRecord)));
+        buffer.resize(static_cast<std::size_t>(file.gcount()) / sizeof(ExternalEdgeRecord));
+        next = 0;
+    }
+
+    bool hasNext() const {
+        return next < buffer.size();
+    }
+
+    const ExternalEdgeRecord &peek() const {
+        return buffer[next];
+    }
+
+    void pop() {
+        next++;
+        if (next == buffer.size()) {
+            refill();
+        }
+    }
+};
+
+/**
+ * k-way merge of sorted runs into outputFilePath, reading each run through a buffer of bufferRecords records
+ */
+static void mergeRuns(const std::vector<std::string> &runPaths, const std::string &outputFilePath,
+                      std::size_t bufferRecords) {
+    std::vector<std::unique_ptr<RunReader>> readers;
+    for (const std::string &runPath: runPaths) {
+        readers.push_back(std::make_unique<RunReader>(runPath, bufferRecords));
+    }
+    auto comparator = [&readers](std::size_t a, std::size_t b) {
+        return recordLess(readers[b]->peek(), readers[a]->peek());
+    };
+    std::priority_queue<std::size_t, std::vector<std::size_t>, decltype(comparator)> heap(comparator);
+    for (std::size_t i = 0; i < readers.size(); ++i) {
+        if (readers[i]->hasNext()) {
+            heap.push(i);
+        }
+    }
+    RecordWriter writer(outputFilePath);
+    while (!heap.empty()) {
+        std::size_t i = heap.top();
+        heap.pop();
+        writer.write(readers[i]->peek());
+        readers[i]->pop();
+        if (readers[i]->hasNext()) {
+            heap.push(i);
+        }
+    }
+    writer.close();
+    readers.clear();
+    for (const std::string &runPath: runPaths) {
+        std::filesystem::remove(runPath);
+    }
+}
+
+void ExternalReducer::externalSort(const std::string &inputFilePath, const std::string &outputFilePath,
+                                   const std::string &workDirectory, std::uint64_t memoryBudgetBytes,
+                                   std::uint64_t mergeBufferRecords) {
+    // runs larger than the input would only allocate memory that is never read
+    std::uint64_t inputRecords = std::filesystem::file_size(inputFilePath) / sizeof(ExternalEdgeRecord);
+    mergeBufferRecords = std::max<std::uint64_t>(mergeBufferRecords, 1);
+    std::uint64_t runRecords = std::min<std::uint64_t>(
+            std::max<std::uint64_t>(memoryBudgetBytes / sizeof(ExternalEdgeRecord), mergeBufferRecords),
+            std::max<std::uint64_t>(inputRecords, 1));
+    std::vector<std::string> runPaths;
+    std::uint64_t nextRun = 0;
+    auto nextRunPath = [&workDirectory, &nextRun]() {
+        return workDirectory + "/run_" + std::to_string(nextRun++) + ".bin";
+    };
+    {
+        std::ifstream input(inputFilePath, std::ios::binary);
+        // every record is read before it is sorted, so the buffer is not zero-filled
+        std::unique_ptr<ExternalEdgeRecord[]> run = std::make_unique_for_overwrite<ExternalEdgeRecord[]>(runRecords);
+        while (true) {
+            input.read(reinterpret_cast<char*>(run.get()),
+                       static_cast<std::streamsize>(runRecords * sizeof(ExternalEdgeRecord)));
+            std::size_t count = static_cast<std::size_t>(input.gcount()) / sizeof(ExternalEdgeRecord);
+            if (count == 0) {
+                break;
+            }
+            std::sort(run.get(), run.get() + count, recordLess);
+            std::string runPath = nextRunPath();
+            std::ofstream output(runPath, std::ios::binary | std::ios::trunc);
+            output.write(reinterpret_cast<const char*>(run.get()),
+                         static_cast<std::streamsize>(count * sizeof(ExternalEdgeRecord)));
+            requireWritten(output, runPath);
+            runPaths.push_back(runPath);
+        }
+    }
+
+    // a single run is already the sorted output
+    if (runPaths.size() <= 1) {
+        if (runPaths.empty()) {
+            std::ofstream(outputFilePath, std::ios::binary | std::ios::trunc);
+        } else {
+            std::filesystem::rename(runPaths[0], outputFilePath);
+        }
+        return;
+    }
+
+    // the read buffers of one merge share the run buffer's budget, so with more runs than buffers of
+    // mergeBufferRecords fit in it, groups of runs are merged into longer runs first
+    std::size_t maxRunsPerMerge = std::max<std::size_t>(static_cast<std::size_t>(runRecords / mergeBufferRecords), 2);
+    while (runPaths.size() > maxRunsPerMerge) {
+        std::vector<std::string> mergedPaths;
+        for (std::size_t first = 0; first < runPaths.size(); first += maxRunsPerMerge) {
+            std::vector<std::string> group(runPaths.begin() + static_cast<std::ptrdiff_t>(first),
+                                           runPaths.begin() + static_cast<std::ptrdiff_t>(
+                                                   std::min(first + maxRunsPerMerge, runPaths.size())));
+            if (group.size() == 1) {
+                mergedPaths.push_back(group[0]);
+                continue;
+            }
+            mergedPaths.push_back(nextRunPath());
+            mergeRuns(group, mergedPaths.back(), static_cast<std::size_t>(runRecords / group.size()));
+        }
+        runPaths = std::move(mergedPaths);
+    }
+    mergeRuns(runPaths, outputFilePath, static_cast<std::size_t>(runRecords / runPaths.size()));
+}
+
+std::vector<std::uint64_t> ExternalReducer::writeDenseEdges(const std::string &inputFilePath,
+                                                           GraphFileFormat inputFormat,
+                                                           const std::string &edgeFilePath,
+                                                           std::uint64_t &numberOfEdges) {
+    std::vector<std::uint64_t> nodeIds;
+    // (node id, dense index) sorted by node id, built once all nodes are read
+    std::vector<std::pair<std::uint64_t, std::uint64_t>> denseIndex;
+    RecordWriter writer(edgeFilePath);
+    std::uint64_t position = 0;
+
+    auto lookup = [&denseIndex](std::uint64_t id) {
+        auto it = std::lower_bound(denseIndex.begin(), denseIndex.end(), std::make_pair(id, std::uint64_t(0)));
+        if (it == denseIndex.end() || it->first != id) {
+            throw std::runtime_error("Edge refers to unknown node " + std::to_string(id));
+        }
+        return it->second;
+    };
+
+    GraphParser::scanFinalGraph(
+            inputFilePath, inputFormat,
+            [&nodeIds, &numberOfEdges](std::uint64_t nodes, std::uint64_t edges) {
+                nodeIds.reserve(nodes);
+                numberOfEdges = edges;
+            },
+            [&nodeIds](const FinalNode &node) {
+                nodeIds.push_back(node.id);
+            },
+            [&](const FinalEdge &edge) {
+                if (denseIndex.size() != nodeIds.size()) {
+                    for (std::uint64_t i = 0; i < nodeIds.size(); ++i) {
+                        denseIndex.emplace_back(nodeIds[i], i);
+                    }
+                    std::sort(denseIndex.begin(), denseIndex.end());
+                }
+                writer.write(ExternalEdgeRecord{lookup(edge.startNodeId), lookup(edge.endNodeId), position});
+                position++;
+            });
+    writer.close();
+    return nodeIds;
+}
+
+std::vector<std::uint64_t> ExternalReducer::topoSort(const std::string &sortedEdgeFilePath,
+                                                     std::uint64_t numberOfNodes) {
+    MappedFile file(sortedEdgeFilePath);
+    const ExternalEdgeRecord* edges = file.records();
+    std::uint64_t numberOfEdges = file.numberOfRecords();
+
+    std::vector<std::uint64_t> offsets(numberOfNodes + 1, 0);
+    std::vector<std::uint64_t> inDegree(numberOfNodes, 0);
+    for (std::uint64_t e = 0; e < numberOfEdges; ++e) {
+        offsets[edges[e].startNode + 1]++;
+        inDegree[edges[e].endNode]++;
+    }
+    for (std::uint64_t i = 0; i < numberOfNodes; ++i) {
+        offsets[i + 1] += offsets[i];
+    }
+
+    // Kahn's algorithm, the queue holds nodes whose incoming edges are all traversed
+    std::vector<std::uint64_t> queue;
+    queue.reserve(numberOfNodes);
+    for (std::uint64_t i = 0; i < numberOfNodes; ++i) {
+        if (inDegree[i] == 0) {
+            queue.push_back(i);
+        }
+    }
+    std::vector<std::uint64_t> topoOrder(numberOfNodes, 0);
+    for (std::uint64_t head = 0; head < queue.size(); ++head) {
+        std::uint64_t node = queue[head];
+        topoOrder[node] = head;
+        for (std::uint64_t e = offsets[node]; e < offsets[node + 1]; ++e) {
+            if (--inDegree[edges[e].endNode] == 0) {
+                queue.push_back(edges[e].endNode);
+            }
+        }
+    }
+    if (queue.size() != numberOfNodes)
+        throw std::runtime_error("This graph contains loop");
+    return topoOrder;
+}
+
+void ExternalReducer::relabelEdges(const std::string &edgeFilePath, const std::string &relabeledFilePath,
+                                   const std::vector<std::uint64_t> &topoOrder) {
+    MappedFile file(edgeFilePath);
+    RecordWriter writer(relabeledFilePath);
+    const ExternalEdgeRecord* edges = file.records();
+    for (std::uint64_t e = 0; e < file.numberOfRecords(); ++e) {
+        writer.write(ExternalEdgeRecord{topoOrder[edges[e].startNode], topoOrder[edges[e].endNode],
+                                        edges[e].position});
+    }
+    writer.close();
+}
+
+std::vector<std::uint64_t> ExternalReducer::reduceChunk(const ExternalEdgeRecord* edges,
+                                                        const std::vector<std::uint64_t> &offsets,
+                                                        std::uint64_t firstSource, std::uint64_t lastSource,
+                                                        std::vector<std::uint64_t> &redundancyBitmap) {
+    std::uint64_t numberOfNodes = offsets.size() - 1;
+    std::uint64_t words = (lastSource - firstSource + 63) / 64;
+    std::uint64_t rows = numberOfNodes - firstSource;
+    // reach: chunk sources reaching the node by a path of length >= 1
+    // longReach: chunk sources reaching the node by a path of length >= 2
+    std::vector<std::uint64_t> reach(rows * words, 0);
+    std::vector<std::uint64_t> longReach(rows * words, 0);
+
+    // nodes are numbered in topological order, so every node is complete when it is visited
+    for (std::uint64_t node = firstSource; node < numberOfNodes; ++node) {
+        const std::uint64_t* nodeReach = &reach[(node - firstSource) * words];
+        bool isSource = node < lastSource;
+        if (!isSource && std::all_of(nodeReach, nodeReach + words, [](std::uint64_t w) { return w == 0; })) {
+            continue;
+        }
+        for (std::uint64_t e = offsets[node]; e < offsets[node + 1]; ++e) {
+            std::uint64_t row = (edges[e].endNode - firstSource) * words;
+            for (std::uint64_t w = 0; w < words; ++w) {
+                reach[row + w] |= nodeReach[w];
+                longReach[row + w] |= nodeReach[w];
+            }
+            if (isSource) {
+                std::uint64_t bit = node - firstSource;
+                reach[row + bit / 64] |= std::uint64_t(1) << (bit % 64);
+            }
+        }
+    }
+
+    // an edge (u, v) is redundant iff u reaches v by a path of length >= 2, or it is a parallel edge followed by
+    // another copy. The records are sorted by end node and position, so the copies are adjacent, the last kept
+    std::vector<std::uint64_t> redundantPositions;
+    for (std::uint64_t node = firstSource; node < lastSource; ++node) {
+        std::uint64_t bit = node - firstSource;
+        for (std::uint64_t e = offsets[node]; e < offsets[node + 1]; ++e) {
+            std::uint64_t row = (edges[e].endNode - firstSource) * words;
+            bool hasLaterCopy = e + 1 < offsets[node + 1] && edges[e + 1].endNode == edges[e].endNode;
+            if (hasLaterCopy || (longReach[row + bit / 64] & (std::uint64_t(1) << (bit % 64)))) {
+                redundancyBitmap[edges[e].position / 64] |= std::uint64_t(1) << (edges[e].position % 64);
+                redundantPositions.push_back(edges[e].position);
+            }
+        }
+    }
+    return redundantPositions;
+}
+
+void ExternalReducer::writeReducedGraph(const std::string &inputFilePath, GraphFileFormat inputFormat,
+                                        const std::string &outputFilePath,
+                                        const std::vector<std::uint64_t> &redundancyBitmap,
+                                        std::uint64_t numberOfRedundantEdges) {
+    BufferedWriter writer(outputFilePath);
+    std::uint64_t position = 0;
+    GraphParser::scanFinalGraph(
+            inputFilePath, inputFormat,
+            [&writer, numberOfRedundantEdges](std::uint64_t numberOfNodes, std::uint64_t numberOfEdges) {
+                writer.writeNumber(numberOfNodes);
+                writer.writeChar(' ');
+                writer.writeNumber(numberOfEdges - numberOfRedundantEdges);
+                writer.writeChar('\n');
+            },
+            [&writer](const FinalNode &node) {
+                writer.writeNumber(node.id);
+                writer.writeChar('\n');
+            },
+            [&](const FinalEdge &edge) {
+                if (!(redundancyBitmap[position / 64] & (std::uint64_t(1) << (position % 64)))) {
+                    writer.writeNumber(edge.id);
+                    writer.writeChar(' ');
+                    writer.writeNumber(edge.startNodeId);
+                    writer.writeChar(' ');
+                    writer.writeNumber(edge.endNodeId);
+                    writer.writeChar('\n');
+                }
+                position++;
+            });
+    writer.close();
+}
+
+/**
+ * progress of a reduction run, stored as "key value" lines in the work directory
+ */
+struct ExternalCheckpoint {
+    std::string inputFilePath;
+    std::uint64_t inputFileSize = 0;
+    std::uint64_t numberOfNodes = 0;
+    std::uint64_t numberOfEdges = 0;
+    std::uint64_t nextSource = 0;
+    std::uint64_t numberOfRedundantEdges = 0;
+
+    bool read(const std::string &path) {
+        std::ifstream file(path);
+        std::string key;
+        int fields = 0;
+        while (file >> key) {
+            if (key == "input") {
+                file >> std::quoted(inputFilePath) >> inputFileSize;
+            } else if (key == "nodes") {
+                file >> numberOfNodes;
+            } else if (key == "edges") {
+                file >> numberOfEdges;
+            } else if (key == "nextSource") {
+                file >> nextSource;
+            } else if (key == "redundantEdges") {
+                file >> numberOfRedundantEdges;
+            } else {
+                return false;
+            }
+            fields++;
+        }
+        return fields == 5;
+    }
+
+    void write(const std::string &path) const {
+        // write a temporary file and rename it, so that a crash never leaves a half written checkpoint
+        std::string temporaryPath = path + ".tmp";
+        {
+            std::ofstream file(temporaryPath, std::ios::trunc);
+            file << "input " << std::quoted(inputFilePath) << " " << inputFileSize << "\n"
+                 << "nodes " << numberOfNodes << "\n"
+                 << "edges " << numberOfEdges << "\n"
+                 << "nextSource " << nextSource << "\n"
+                 << "redundantEdges " << numberOfRedundantEdges << "\n";
+            requireWritten(file, temporaryPath);
+        }
+        std::filesystem::rename(temporaryPath, path);
+    }
+};
+
+std::uint64_t ExternalReducer::reduceGraphFile(std::string inputFilePath, std::string outputFilePath,
+                                               const ExternalReductionConfig &config) {
+    std::filesystem::create_directories(config.workDirectory);
+    const std::string denseEdgesPath = config.workDirectory + "/dense_edges.bin";
+    const std::string denseSortedPath = config.workDirectory + "/dense_sorted.bin";
+    const std::string topoEdgesPath = config.workDirectory + "/topo_edges.bin";
+    const std::string topoSortedPath = config.workDirectory + "/topo_sorted.bin";
+    const std::string positionsPath = config.workDirectory + "/redundant_positions.bin";
+    const std::string checkpointPath = config.workDirectory + "/checkpoint.txt";
+
+    ExternalCheckpoint checkpoint;
+    std::uint64_t inputFileSize = std::filesystem::file_size(inputFilePath);
+    bool resumed = config.resume
+                   && checkpoint.read(checkpointPath)
+                   && checkpoint.inputFilePath == inputFilePath
+                   && checkpoint.inputFileSize == inputFileSize
+                   && std::filesystem::exists(topoSortedPath)
+                   && std::filesystem::file_size(topoSortedPath)
+                      == checkpoint.numberOfEdges * sizeof(ExternalEdgeRecord);
+
+    std::vector<std::uint64_t> redundancyBitmap;
+    if (resumed) {
+        // drop positions appended after the last checkpoint was written
+        std::filesystem::resize_file(positionsPath, checkpoint.numberOfRedundantEdges * sizeof(std::uint64_t));
+        redundancyBitmap.assign((checkpoint.numberOfEdges + 63) / 64, 0);
+        std::ifstream positions(positionsPath, std::ios::binary);
+        std::uint64_t position;
+        while (positions.read(reinterpret_cast<char*>(&position), sizeof(position))) {
+            redundancyBitmap[position / 64] |= std::uint64_t(1) << (position % 64);
+        }
+    } else {
+        // sorting stages are not checkpointed, they always restart from the input file
+        checkpoint = ExternalCheckpoint();
+        checkpoint.inputFilePath = inputFilePath;
+        checkpoint.inputFileSize = inputFileSize;
+        std::vector<std::uint64_t> nodeIds = writeDenseEdges(inputFilePath, config.inputFormat, denseEdgesPath,
+                                                             checkpoint.numberOfEdges);
+        checkpoint.numberOfNodes = nodeIds.size();
+        nodeIds = std::vector<std::uint64_t>();
+
+        externalSort(denseEdgesPath, denseSortedPath, config.workDirectory, config.memoryBudgetBytes,
+                     config.mergeBufferRecords);
+        std::filesystem::remove(denseEdgesPath);
+        std::vector<std::uint64_t> topoOrder = topoSort(denseSortedPath, checkpoint.numberOfNodes);
+        relabelEdges(denseSortedPath, topoEdgesPath, topoOrder);
+        topoOrder = std::vector<std::uint64_t>();
+        std::filesystem::remove(denseSortedPath);
+        externalSort(topoEdgesPath, topoSortedPath, config.workDirectory, config.memoryBudgetBytes,
+                     config.mergeBufferRecords);
+        std::filesystem::remove(topoEdgesPath);
+
+        std::ofstream(positionsPath, std::ios::binary | std::ios::trunc);
+        redundancyBitmap.assign((checkpoint.numberOfEdges + 63) / 64, 0);
+        checkpoint.write(checkpointPath);
+    }
+
+    {
+        MappedFile sortedEdges(topoSortedPath);
+        const ExternalEdgeRecord* edges = sortedEdges.records();
+        std::uint64_t numberOfNodes = checkpoint.numberOfNodes;
+        std::vector<std::uint64_t> offsets(numberOfNodes + 1, 0);
+        for (std::uint64_t e = 0; e < sortedEdges.numberOfRecords(); ++e) {
+            offsets[edges[e].startNode + 1]++;
+        }
+        for (std::uint64_t i = 0; i < numberOfNodes; ++i) {
+            offsets[i + 1] += offsets[i];
+        }
+
+        // the reach and longReach bitsets of a pass take 16 bytes per node and 64-source word
+        std::uint64_t fixedBytes = offsets.size() * sizeof(std::uint64_t)
+                                   + redundancyBitmap.size() * sizeof(std::uint64_t);
+        std::uint64_t bitsetBytes = config.memoryBudgetBytes > fixedBytes ? config.memoryBudgetBytes - fixedBytes : 0;
+        std::uint64_t words = std::max<std::uint64_t>(bitsetBytes / (16 * std::max<std::uint64_t>(numberOfNodes, 1)),
+                                                      1);
+        std::uint64_t chunkSize = 64 * words;
+
+        std::ofstream positions(positionsPath, std::ios::binary | std::ios::app);
+        while (checkpoint.nextSource < numberOfNodes) {
+            std::uint64_t lastSource = std::min(checkpoint.nextSource + chunkSize, numberOfNodes);
+            std::vector<std::uint64_t> redundantPositions =
+                    reduceChunk(edges, offsets, checkpoint.nextSource, lastSource, redundancyBitmap);
+            positions.write(reinterpret_cast<const char*>(redundantPositions.data()),
+                            static_cast<std::streamsize>(redundantPositions.size() * sizeof(std::uint64_t)));
+            // the checkpoint must not count positions that did not reach the file
+            requireWritten(positions, positionsPath);
+            checkpoint.numberOfRedundantEdges += redundantPositions.size();
+            checkpoint.nextSource = lastSource;
+            checkpoint.write(checkpointPath);
+        }
+    }
+
+    writeReducedGraph(inputFilePath, config.inputFormat, outputFilePath, redundancyBitmap,
+                      checkpoint.numberOfRedundantEdges);
+    std::filesystem::remove(topoSortedPath);
+    std::filesystem::remove(positionsPath);
+    std::filesystem::remove(checkpointPath);
+    return checkpoint.numberOfRedundantEdges;
+}
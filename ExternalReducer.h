@@ -0,0 +1,105 @@
+/**
+ * @file ExternalReducer.h
+ * @brief This file contains the out-of-core transitive reduction for graphs whose edges do not fit in memory
+ * alongside a reachability index.
+ */
+#ifndef ALGORITHMPROJECT_EXTERNALREDUCER_H
+#define ALGORITHMPROJECT_EXTERNALREDUCER_H
+
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "GraphParser.h"
+
+/**
+ * @brief settings of an out-of-core reduction run
+ */
+struct ExternalReductionConfig {
+    // directory for sorted runs, sorted edge files and the checkpoint. Created if it does not exist
+    std::string workDirectory = "external_reduction";
+    // upper bound for the RAM used by sort buffers and reachability bitsets
+    std::uint64_t memoryBudgetBytes = std::uint64_t(1) << 30;
+    // continue from the checkpoint in workDirectory if it belongs to the same input file
+    bool resume = true;
+    // records of the smallest read buffer of a run during the merge, which is also the smallest run. Only lowered
+    // to sort small graphs in many runs and merge passes, as DifferentialTester does
+    std::uint64_t mergeBufferRecords = 1 << 10;
+    // format of the input file, e.g. from GraphParser::detectGraphFileFormat. The reduced graph is always text
+    GraphFileFormat inputFormat = GraphFileFormat::Text;
+};
+
+/**
+ * @brief an edge as stored in the on-disk edge files. Nodes are dense indices (file order first,
+ * topological order after relabeling), position is the index of the edge in the input file.
+ */
+struct ExternalEdgeRecord {
+    std::uint64_t startNode;
+    std::uint64_t endNode;
+    std::uint64_t position;
+};
+
+class ExternalReducer {
+public:
+    /**
+     * @brief compute the transitive reduction of a graph file and write the reduced graph to outputFilePath as txt.
+     *
+     * Only O(n) node data is kept in memory. Edges are externally sorted by the topological order of their starting
+     * and end nodes, then the redundant edges are found in passes over the memory-mapped sorted edge file. Every pass
+     * takes the next chunk of starting nodes in topological order, as many as the reachability bitsets for the
+     * memory budget allow. A checkpoint is written after every pass, so an interrupted run resumes at the next chunk.
+     *
+     * @return the number of redundant edges
+     */
+    static std::uint64_t reduceGraphFile(std::string inputFilePath, std::string outputFilePath,
+                                         const ExternalReductionConfig &config);
+
+    /**
+     * @brief sort the ExternalEdgeRecords of inputFilePath by (startNode, endNode, position) into outputFilePath,
+     * using sorted runs of at most memoryBudgetBytes, but at least mergeBufferRecords records, and k-way merges
+     * that read each run through at least mergeBufferRecords records.
+     */
+    static void externalSort(const std::string &inputFilePath, const std::string &outputFilePath,
+                             const std::string &workDirectory, std::uint64_t memoryBudgetBytes,
+                             std::uint64_t mergeBufferRecords = 1 << 10);
+
+private:
+    /**
+     * @brief write the input edges as records of dense node indices in file order. Returns node ids in file order.
+     */
+    static std::vector<std::uint64_t> writeDenseEdges(const std::string &inputFilePath, GraphFileFormat inputFormat,
+                                                      const std::string &edgeFilePath,
+                                                      std::uint64_t &numberOfEdges);
+
+    /**
+     * @brief compute the topological order of every dense node from the edge file sorted by starting node
+     */
+    static std::vector<std::uint64_t> topoSort(const std::string &sortedEdgeFilePath, std::uint64_t numberOfNodes);
+
+    /**
+     * @brief rewrite the records of edgeFilePath with node indices replaced by their topological order
+     */
+    static void relabelEdges(const std::string &edgeFilePath, const std::string &relabeledFilePath,
+                             const std::vector<std::uint64_t> &topoOrder);
+
+    /**
+     * @brief mark the redundant edges of the sources in [firstSource, lastSource) in redundancyBitmap,
+     * which is indexed by input position. Of parallel edges only the last in input order is kept, as by
+     * TransitiveReducer. Returns the positions marked in this pass.
+     */
+    static std::vector<std::uint64_t> reduceChunk(const ExternalEdgeRecord* edges,
+                                                  const std::vector<std::uint64_t> &offsets,
+                                                  std::uint64_t firstSource, std::uint64_t lastSource,
+                                                  std::vector<std::uint64_t> &redundancyBitmap);
+
+    /**
+     * @brief stream the input file again and write all nodes and the edges not marked in redundancyBitmap
+     */
+    static void writeReducedGraph(const std::string &inputFilePath, GraphFileFormat inputFormat,
+                                  const std::string &outputFilePath,
+                                  const std::vector<std::uint64_t> &redundancyBitmap,
+                                  std::uint64_t numberOfRedundantEdges);
+};
+
+
+#endif //ALGORITHMPROJECT_EXTERNALREDUCER_H
@@ -4,24 +4,103 @@
  * @brief This file contains the definition of FinalGraph, FinalNode and FinalEdge,
  * which is a streamlined format of intermediateGraph/Node/Edge,
  * thus more convenient to communicate with graph generator and visualizer written as separate programs.
+ *
+ * FinalGraph stores its nodes and edges as flat arrays (struct of arrays), so a graph is a handful of allocations
+ * regardless of its size. FinalGraphView is the non-owning variant over the same arrays, used to hand a graph over
+ * without copying it.
  */
+#ifndef ALGORITHMPROJECT_FINALGRAPH_H
+#define ALGORITHMPROJECT_FINALGRAPH_H
+
+
 #include <cstdint>
+#include <span>
 #include <vector>
 
 /**
- *
+ * a single node record, used when nodes are streamed one at a time
  */
 struct FinalNode {
     std::uint64_t id;
 };
 
+/**
+ * a single edge record, used when edges are streamed one at a time
+ */
 struct FinalEdge {
     std::uint64_t id;
     std::uint64_t startNodeId;
     std::uint64_t endNodeId;
 };
 
+/**
+ * non-owning view of a graph in FinalGraph layout. The viewed arrays must outlive the view.
+ */
+struct FinalGraphView {
+    std::span<const std::uint64_t> nodeIds;
+    std::span<const std::uint64_t> edgeIds;
+    std::span<const std::uint64_t> edgeStartNodeIds;
+    std::span<const std::uint64_t> edgeEndNodeIds;
+
+    std::uint64_t numberOfNodes() const {
+        return nodeIds.size();
+    }
+
+    std::uint64_t numberOfEdges() const {
+        return edgeIds.size();
+    }
+
+    FinalEdge edge(std::uint64_t i) const {
+        return FinalEdge{edgeIds[i], edgeStartNodeIds[i], edgeEndNodeIds[i]};
+    }
+};
+
+/**
+ * owning graph in struct of arrays layout. Edge i is (edgeIds[i], edgeStartNodeIds[i], edgeEndNodeIds[i]).
+ */
 struct FinalGraph {
-    std::vector<FinalNode*> nodes;
-    std::vector<FinalEdge*> edges;
-};
\ No newline at end of file
+    std::vector<std::uint64_t> nodeIds;
+    std::vector<std::uint64_t> edgeIds;
+    std::vector<std::uint64_t> edgeStartNodeIds;
+    std::vector<std::uint64_t> edgeEndNodeIds;
+
+    void reserve(std::uint64_t numberOfNodes, std::uint64_t numberOfEdges) {
+        nodeIds.reserve(numberOfNodes);
+        edgeIds.reserve(numberOfEdges);
+        edgeStartNodeIds.reserve(numberOfEdges);
+        edgeEndNodeIds.reserve(numberOfEdges);
+    }
+
+    void addNode(const FinalNode &node) {
+        nodeIds.push_back(node.id);
+    }
+
+    void addEdge(const FinalEdge &edge) {
+        edgeIds.push_back(edge.id);
+        edgeStartNodeIds.push_back(edge.startNodeId);
+        edgeEndNodeIds.push_back(edge.endNodeId);
+    }
+
+    std::uint64_t numberOfNodes() const {
+        return nodeIds.size();
+    }
+
+    std::uint64_t numberOfEdges() const {
+        return edgeIds.size();
+    }
+
+    FinalEdge edge(std::uint64_t i) const {
+        return FinalEdge{edgeIds[i], edgeStartNodeIds[i], edgeEndNodeIds[i]};
+    }
+
+    FinalGraphView view() const {
+        return FinalGraphView{nodeIds, edgeIds, edgeStartNodeIds, edgeEndNodeIds};
+    }
+
+    operator FinalGraphView() const {
+        return view();
+    }
+};
+
+
+#endif //ALGORITHMPROJECT_FINALGRAPH_H
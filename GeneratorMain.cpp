@@ -0,0 +1,72 @@
+//
+// command line front end of GraphGenerator
+//
+
+#include "GraphGenerator.h"
+#include <iostream>
+#include <string>
+
+
+static void printUsage() {
+    std::cerr << "usage: GraphGenerator --output <file> [--model er|layered|powerlaw|chain|closure]\n"
+                 "                      [--nodes <n>] [--edges <m>] [--depth <d>] [--exponent <a>]\n"
+                 "                      [--seed <s>] [--threads <t>] [--format text|binary] [--no-shuffle]\n";
+}
+
+int main(int argc, char* argv[]) {
+    GeneratorConfig config;
+    std::string output;
+    GraphFileFormat format = GraphFileFormat::Text;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string option = argv[i];
+            if (option == "--no-shuffle") {
+                config.shuffleNodeIds = false;
+                continue;
+            }
+            if (i + 1 >= argc) {
+                printUsage();
+                return 2;
+            }
+            std::string value = argv[++i];
+            if (option == "--output") {
+                output = value;
+            } else if (option == "--model") {
+                config.model = GraphGenerator::parseModel(value);
+            } else if (option == "--nodes") {
+                config.numberOfNodes = std::stoull(value);
+            } else if (option == "--edges") {
+                config.numberOfEdges = std::stoull(value);
+            } else if (option == "--depth") {
+                config.depth = std::stoull(value);
+            } else if (option == "--exponent") {
+                config.powerLawExponent = std::stod(value);
+            } else if (option == "--seed") {
+                config.seed = std::stoull(value);
+            } else if (option == "--threads") {
+                config.numberOfThreads = static_cast<unsigned>(std::stoul(value));
+            } else if (option == "--format" && (value == "text" || value == "binary")) {
+                format = value == "text" ? GraphFileFormat::Text : GraphFileFormat::Binary;
+            } else {
+                printUsage();
+                return 2;
+            }
+        }
+    } catch (const std::logic_error &error) {
+        std::cerr << "invalid argument: " << error.what() << "\n";
+        printUsage();
+        return 2;
+    }
+    if (output.empty()) {
+        printUsage();
+        return 2;
+    }
+
+    try {
+        GraphGenerator::generateToFile(config, output, format);
+    } catch (const std::exception &error) {
+        std::cerr << error.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,312 @@
+//
+// GraphGenerator builds random DAGs block by block on a pool of threads
+//
+
+#include "GraphGenerator.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <stdexcept>
+
+
+/**
+ * xoshiro256** seeded through splitmix64. Every generation block gets its own stream, so the output does not
+ * depend on which thread runs the block.
+ */
+class RandomStream {
+public:
+    RandomStream(std::uint64_t seed, std::uint64_t stream) {
+        std::uint64_t x = seed ^ (stream * UINT64_C(0x9e3779b97f4a7c15));
+        for (std::uint64_t &word: state) {
+            x += UINT64_C(0x9e3779b97f4a7c15);
+            std::uint64_t z = x;
+            z = (z ^ (z >> 30)) * UINT64_C(0xbf58476d1ce4e5b9);
+            z = (z ^ (z >> 27)) * UINT64_C(0x94d049bb133111eb);
+            word = z ^ (z >> 31);
+        }
+    }
+
+    std::uint64_t next() {
+        std::uint64_t result = std::rotl(state[1] * 5, 7) * 9;
+        std::uint64_t t = state[1] << 17;
+        state[2] ^= state[0];
+        state[3] ^= state[1];
+        state[1] ^= state[2];
+        state[0] ^= state[3];
+        state[2] ^= t;
+        state[3] = std::rotl(state[3], 45);
+        return result;
+    }
+
+    /**
+     * uniform in [0, 1)
+     */
+    double nextDouble() {
+        return static_cast<double>(next() >> 11) * 0x1.0p-53;
+    }
+
+    /**
+     * uniform in [0, bound)
+     */
+    std::uint64_t nextBelow(std::uint64_t bound) {
+        return static_cast<std::uint64_t>((static_cast<unsigned __int128>(next()) * bound) >> 64);
+    }
+
+    /**
+     * floor(mean) or floor(mean) + 1, with the given mean
+     */
+    std::uint64_t nextRounded(double mean) {
+        auto whole = static_cast<std::uint64_t>(mean);
+        return whole + (nextDouble() < mean - static_cast<double>(whole) ? 1 : 0);
+    }
+
+private:
+    std::uint64_t state[4];
+};
+
+GeneratorModel GraphGenerator::parseModel(const std::string &name) {
+    if (name == "er")
+        return GeneratorModel::ErdosRenyi;
+    if (name == "layered")
+        return GeneratorModel::Layered;
+    if (name == "powerlaw")
+        return GeneratorModel::PowerLaw;
+    if (name == "chain")
+        return GeneratorModel::ChainHeavy;
+    if (name == "closure")
+        return GeneratorModel::ClosureHeavy;
+    throw std::invalid_argument("Unknown generator model " + name);
+}
+
+std::vector<std::uint64_t> GraphGenerator::generateNodeIds(const GeneratorConfig &config) {
+    std::vector<std::uint64_t> nodeIds(config.numberOfNodes);
+    for (std::uint64_t i = 0; i < config.numberOfNodes; ++i) {
+        nodeIds[i] = i;
+    }
+    if (config.shuffleNodeIds) {
+        RandomStream random(config.seed, UINT64_MAX);
+        for (std::uint64_t i = config.numberOfNodes; i > 1; --i) {
+            std::swap(nodeIds[i - 1], nodeIds[random.nextBelow(i)]);
+        }
+    }
+    return nodeIds;
+}
+
+std::vector<std::uint64_t> GraphGenerator::generateSkeleton(const GeneratorConfig &config) {
+    std::uint64_t n = config.numberOfNodes;
+    std::vector<std::uint64_t> skeleton(n * skeletonDegree, n);
+    std::uint64_t window = std::max<std::uint64_t>(n / std::max<std::uint64_t>(config.depth, 1), 2);
+    runParallel((n + blockSize - 1) / blockSize, config.numberOfThreads, [&](std::uint64_t blockIndex, unsigned) {
+        RandomStream random(config.seed, 2 * blockIndex + 1);
+        std::uint64_t lastSource = std::min(n, (blockIndex + 1) * blockSize);
+        for (std::uint64_t u = blockIndex * blockSize; u < lastSource; ++u) {
+            std::uint64_t candidates = std::min(window, n - 1 - u);
+            for (std::uint64_t k = 0; k < skeletonDegree && candidates > 0; ++k) {
+                skeleton[u * skeletonDegree + k] = u + 1 + random.nextBelow(candidates);
+            }
+        }
+    });
+    return skeleton;
+}
+
+void GraphGenerator::generateBlock(const GeneratorConfig &config, std::uint64_t blockIndex,
+                                   const std::vector<std::uint64_t> &skeleton, EdgeBlock &block) {
+    RandomStream random(config.seed, 2 * blockIndex);
+    const std::uint64_t n = config.numberOfNodes;
+    const std::uint64_t depth = std::clamp<std::uint64_t>(config.depth, 1, std::max<std::uint64_t>(n, 1));
+    const std::uint64_t width = std::max<std::uint64_t>(n / depth, 1);
+    const double averageDegree = n > 0 ? static_cast<double>(config.numberOfEdges) / static_cast<double>(n) : 0;
+    const std::uint64_t firstSource = blockIndex * blockSize;
+    const std::uint64_t lastSource = std::min(n, firstSource + blockSize);
+    std::vector<std::uint64_t> targets;
+
+    for (std::uint64_t u = firstSource; u < lastSource; ++u) {
+        // number of nodes after u in topological order
+        const std::uint64_t later = n - 1 - u;
+        targets.clear();
+        switch (config.model) {
+            case GeneratorModel::ErdosRenyi: {
+                // geometric skipping over the candidates (u, n), each taken with probability p
+                double pairs = static_cast<double>(n) * static_cast<double>(n - 1) / 2;
+                double p = std::min(1.0, static_cast<double>(config.numberOfEdges) / std::max(pairs, 1.0));
+                if (p <= 0)
+                    break;
+                double logMiss = std::log1p(-p);
+                for (std::uint64_t v = u;;) {
+                    double skip = p >= 1 ? 0 : std::floor(std::log1p(-random.nextDouble()) / logMiss);
+                    if (skip >= static_cast<double>(n - 1 - v))
+                        break;
+                    v += 1 + static_cast<std::uint64_t>(skip);
+                    targets.push_back(v);
+                }
+                break;
+            }
+            case GeneratorModel::Layered: {
+                // layer l holds [l * width, (l + 1) * width), the last layer also takes the remainder
+                std::uint64_t layer = std::min(u / width, depth - 1);
+                if (layer + 1 >= depth)
+                    break;
+                std::uint64_t nextLayerStart = (layer + 1) * width;
+                std::uint64_t nextLayerSize = layer + 2 >= depth ? n - nextLayerStart : width;
+                // only the nodes outside the last layer have outgoing edges
+                double layerDegree = averageDegree * static_cast<double>(n)
+                                     / static_cast<double>((depth - 1) * width);
+                std::uint64_t degree = std::min(random.nextRounded(layerDegree), later);
+                for (std::uint64_t k = 0; k < degree; ++k) {
+                    if (random.nextDouble() < 0.1) {
+                        targets.push_back(nextLayerStart + random.nextBelow(n - nextLayerStart));
+                    } else {
+                        targets.push_back(nextLayerStart + random.nextBelow(nextLayerSize));
+                    }
+                }
+                break;
+            }
+            case GeneratorModel::PowerLaw: {
+                // Pareto distributed out-degree whose mean is the average degree
+                double exponent = std::max(config.powerLawExponent, 2.01);
+                double minimum = averageDegree * (exponent - 2) / (exponent - 1);
+                double sample = minimum * std::pow(1 - random.nextDouble(), -1 / (exponent - 1));
+                std::uint64_t degree = std::min<std::uint64_t>(random.nextRounded(std::min(sample, 1e18)), later);
+                for (std::uint64_t k = 0; k < degree; ++k) {
+                    targets.push_back(u + 1 + random.nextBelow(later));
+                }
+                break;
+            }
+            case GeneratorModel::ChainHeavy: {
+                // chain c holds [c * depth, (c + 1) * depth), its backbone connects consecutive nodes
+                std::uint64_t chainEnd = std::min(n, (u / depth + 1) * depth);
+                double extraDegree = std::max(0.0, averageDegree - 1);
+                if (u + 1 < chainEnd) {
+                    targets.push_back(u + 1);
+                } else {
+                    extraDegree += 1;
+                }
+                std::uint64_t degree = later > 0 ? random.nextRounded(extraDegree) : 0;
+                for (std::uint64_t k = 0; k < degree; ++k) {
+                    if (u + 1 < chainEnd && random.nextDouble() < 0.8) {
+                        targets.push_back(u + 1 + random.nextBelow(chainEnd - u - 1));
+                    } else {
+                        targets.push_back(u + 1 + random.nextBelow(later));
+                    }
+                }
+                break;
+            }
+            case GeneratorModel::ClosureHeavy: {
+                for (std::uint64_t k = 0; k < skeletonDegree; ++k) {
+                    if (skeleton[u * skeletonDegree + k] < n) {
+                        targets.push_back(skeleton[u * skeletonDegree + k]);
+                    }
+                }
+                if (targets.empty())
+                    break;
+                // shortcut edges to the ends of random skeleton walks of 2 to depth hops
+                std::uint64_t degree = random.nextRounded(std::max(0.0, averageDegree - skeletonDegree));
+                for (std::uint64_t k = 0; k < degree; ++k) {
+                    std::uint64_t hops = 2 + random.nextBelow(std::max<std::uint64_t>(depth, 2) - 1);
+                    std::uint64_t node = u;
+                    std::uint64_t taken = 0;
+                    for (; taken < hops; ++taken) {
+                        std::uint64_t next = skeleton[node * skeletonDegree + random.nextBelow(skeletonDegree)];
+                        if (next >= n)
+                            break;
+                        node = next;
+                    }
+                    if (taken >= 2) {
+                        targets.push_back(node);
+                    }
+                }
+                break;
+            }
+        }
+        std::sort(targets.begin(), targets.end());
+        targets.erase(std::unique(targets.begin(), targets.end()), targets.end());
+        for (std::uint64_t v: targets) {
+            block.startNodes.push_back(u);
+            block.endNodes.push_back(v);
+        }
+    }
+}
+
+std::vector<GraphGenerator::EdgeBlock> GraphGenerator::generateBlocks(const GeneratorConfig &config) {
+    std::vector<std::uint64_t> skeleton;
+    if (config.model == GeneratorModel::ClosureHeavy) {
+        skeleton = generateSkeleton(config);
+    }
+    std::vector<EdgeBlock> blocks((config.numberOfNodes + blockSize - 1) / blockSize);
+    runParallel(blocks.size(), config.numberOfThreads, [&](std::uint64_t blockIndex, unsigned) {
+        generateBlock(config, blockIndex, skeleton, blocks[blockIndex]);
+    });
+    return blocks;
+}
+
+FinalGraph GraphGenerator::generate(const GeneratorConfig &config) {
+    std::vector<EdgeBlock> blocks = generateBlocks(config);
+    FinalGraph graph;
+    graph.nodeIds = generateNodeIds(config);
+    std::uint64_t numberOfEdges = 0;
+    for (const EdgeBlock &block: blocks) {
+        numberOfEdges += block.startNodes.size();
+    }
+    graph.reserve(config.numberOfNodes, numberOfEdges);
+    for (EdgeBlock &block: blocks) {
+        for (std::uint64_t i = 0; i < block.startNodes.size(); ++i) {
+            graph.addEdge(FinalEdge{graph.edgeIds.size(), graph.nodeIds[block.startNodes[i]],
+                                    graph.nodeIds[block.endNodes[i]]});
+        }
+        block = EdgeBlock();
+    }
+    return graph;
+}
+
+void GraphGenerator::generateToFile(const GeneratorConfig &config, std::string title, GraphFileFormat format) {
+    std::vector<EdgeBlock> blocks = generateBlocks(config);
+    std::vector<std::uint64_t> nodeIds = generateNodeIds(config);
+    std::uint64_t numberOfEdges = 0;
+    for (const EdgeBlock &block: blocks) {
+        numberOfEdges += block.startNodes.size();
+    }
+
+    BufferedWriter writer(title);
+    if (format == GraphFileFormat::Binary) {
+        // same layout as GraphParser::exportFinalGraphBinary, edge ids are the positions in block order
+        std::uint64_t header[2] = {config.numberOfNodes, numberOfEdges};
+        writer.writeBytes("TRGRAPH1", 8);
+        writer.writeWords(header, 2);
+        writer.writeWords(nodeIds.data(), nodeIds.size());
+        for (std::uint64_t id = 0; id < numberOfEdges; ++id) {
+            writer.writeWords(&id, 1);
+        }
+        for (const EdgeBlock &block: blocks) {
+            for (std::uint64_t node: block.startNodes) {
+                writer.writeWords(&nodeIds[node], 1);
+            }
+        }
+        for (const EdgeBlock &block: blocks) {
+            for (std::uint64_t node: block.endNodes) {
+                writer.writeWords(&nodeIds[node], 1);
+            }
+        }
+    } else {
+        writer.writeNumber(config.numberOfNodes);
+        writer.writeChar(' ');
+        writer.writeNumber(numberOfEdges);
+        writer.writeChar('\n');
+        for (std::uint64_t id: nodeIds) {
+            writer.writeNumber(id);
+            writer.writeChar('\n');
+        }
+        std::uint64_t id = 0;
+        for (const EdgeBlock &block: blocks) {
+            for (std::uint64_t i = 0; i < block.startNodes.size(); ++i) {
+                writer.writeNumber(id++);
+                writer.writeChar(' ');
+                writer.writeNumber(nodeIds[block.startNodes[i]]);
+                writer.writeChar(' ');
+                writer.writeNumber(nodeIds[block.endNodes[i]]);
+                writer.writeChar('\n');
+            }
+        }
+    }
+    writer.close();
+}
@@ -0,0 +1,110 @@
+/**
+ * @file GraphGenerator.h
+ * @brief This file contains the random DAG generator used to build benchmark graphs of controllable size, density,
+ * width and depth. Generation is seeded and deterministic: the same config gives the same graph for any thread count.
+ */
+#ifndef ALGORITHMPROJECT_GRAPHGENERATOR_H
+#define ALGORITHMPROJECT_GRAPHGENERATOR_H
+
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "FinalGraph.h"
+#include "GraphParser.h"
+
+/**
+ * @brief shape of the generated DAG. Nodes are generated in a hidden topological order and every edge points
+ * forward in it, so all models are acyclic.
+ */
+enum class GeneratorModel {
+    // every forward pair is an edge with the same probability
+    ErdosRenyi,
+    // depth layers of equal width, edges go to the next layer and occasionally skip further
+    Layered,
+    // out-degrees follow a power law, targets are uniform among later nodes
+    PowerLaw,
+    // chains of length depth with extra forward edges along the chain, most of which are redundant
+    ChainHeavy,
+    // a sparse skeleton plus edges to nodes reachable over up to depth skeleton hops, all of which are redundant
+    ClosureHeavy
+};
+
+/**
+ * @brief settings of a generated graph
+ */
+struct GeneratorConfig {
+    GeneratorModel model = GeneratorModel::ErdosRenyi;
+    std::uint64_t numberOfNodes = 1000;
+    // target number of edges. The generated count is close to it but not exact, duplicate edges are dropped,
+    // so short chains or windows that cannot hold that many distinct edges end up sparser
+    std::uint64_t numberOfEdges = 5000;
+    // number of layers (Layered), chain length (ChainHeavy) or maximum walk length (ClosureHeavy).
+    // The width of a layer or the number of chains is numberOfNodes / depth.
+    std::uint64_t depth = 10;
+    // exponent of the out-degree distribution of PowerLaw, must be greater than 2
+    double powerLawExponent = 2.5;
+    std::uint64_t seed = 1;
+    // 0 uses all hardware threads
+    unsigned numberOfThreads = 0;
+    // randomly permute node ids, so that file order does not reveal the topological order
+    bool shuffleNodeIds = true;
+};
+
+class GraphGenerator {
+public:
+    /**
+     * @brief generate a random DAG in memory
+     */
+    static FinalGraph generate(const GeneratorConfig &config);
+
+    /**
+     * @brief generate a random DAG and write it straight to a txt or binary graph file, without building
+     * a FinalGraph first
+     */
+    static void generateToFile(const GeneratorConfig &config, std::string title, GraphFileFormat format);
+
+    /**
+     * @brief parse a model name: er, layered, powerlaw, chain or closure. Throws std::invalid_argument otherwise.
+     */
+    static GeneratorModel parseModel(const std::string &name);
+
+private:
+    // sources per generation block. Fixed, so that the random streams do not depend on the thread count
+    static constexpr std::uint64_t blockSize = 4096;
+    // out-degree of the sparse skeleton of ClosureHeavy
+    static constexpr std::uint64_t skeletonDegree = 2;
+
+    /**
+     * @brief the edges generated for one block of sources, as topological positions
+     */
+    struct EdgeBlock {
+        std::vector<std::uint64_t> startNodes;
+        std::vector<std::uint64_t> endNodes;
+    };
+
+    /**
+     * @brief generate all edge blocks in parallel
+     */
+    static std::vector<EdgeBlock> generateBlocks(const GeneratorConfig &config);
+
+    /**
+     * @brief generate the edges of the sources of block blockIndex. skeleton holds the skeleton targets of
+     * ClosureHeavy and is empty for the other models.
+     */
+    static void generateBlock(const GeneratorConfig &config, std::uint64_t blockIndex,
+                              const std::vector<std::uint64_t> &skeleton, EdgeBlock &block);
+
+    /**
+     * @brief generate the skeleton of ClosureHeavy, skeletonDegree targets per node, numberOfNodes if absent
+     */
+    static std::vector<std::uint64_t> generateSkeleton(const GeneratorConfig &config);
+
+    /**
+     * @brief node id of every topological position
+     */
+    static std::vector<std::uint64_t> generateNodeIds(const GeneratorConfig &config);
+};
+
+
+#endif //ALGORITHMPROJECT_GRAPHGENERATOR_H
@@ -1,112 +1,378 @@
 
 #include "GraphParser.h"
+#include "BitKernels.h"
+#include <algorithm>
+#include <charconv>
 #include <fstream>
 #include <iostream>
+#include <memory>
+#include <stdexcept>
 
 
-IntermediateGraph* GraphParser::parseToIntermediateGraph(FinalGraph* finalGraph) {
-    IntermediateGraph* intermediateGraph = new IntermediateGraph();
-    std::map<uint64_t, IntermediateNode*> nodeMap;
-    for (FinalNode* finalNode: finalGraph->nodes) {
-        IntermediateNode* node = new IntermediateNode(finalNode->id);
-        nodeMap.emplace(finalNode->id, node);
-        intermediateGraph->nodes.push_back(node);
-    }
-    for (FinalEdge* finalEdge: finalGraph->edges) {
-        IntermediateEdge* edge = new IntermediateEdge(finalEdge->id);
-        edge->startNode = nodeMap[finalEdge->startNodeId];
-        edge->endNode = nodeMap[finalEdge->endNodeId];
-        edge->startNode->outgoingEdges.push_back(edge);
-        edge->endNode->incomingEdges.push_back(edge);
-        intermediateGraph->edges.push_back(edge);
-    }
-    for (IntermediateNode* node: intermediateGraph->nodes) {
-        if (node->incomingEdges.empty()) {
-            intermediateGraph->startingNodes.push_back(node);
-        }
-    }
-    return intermediateGraph;
+std::unique_ptr<IntermediateGraph> GraphParser::parseToIntermediateGraph(FinalGraph &&finalGraph) {
+    return std::make_unique<IntermediateGraph>(std::move(finalGraph));
 }
 
 
-FinalGraph* GraphParser::parseToFinalGraph(IntermediateGraph* intermediateGraph) {
-    FinalGraph* finalGraph = new FinalGraph();
-    for (const auto &item: intermediateGraph->nodes) {
-        FinalNode* node = new FinalNode{item->id};
-        finalGraph->nodes.push_back(node);
+FinalGraphView GraphParser::parseToFinalGraph(const IntermediateGraph* intermediateGraph) {
+    return intermediateGraph->source.view();
+}
+
+/**
+ * write the graph in txt format. Edges marked in redundancyBitmap are skipped if it is not empty
+ */
+static void writeTextGraph(BufferedWriter &writer, FinalGraphView finalGraph,
+                           const std::vector<std::uint64_t> &redundancyBitmap, std::uint64_t numberOfEdges) {
+    writer.writeNumber(finalGraph.numberOfNodes());
+    writer.writeChar(' ');
+    writer.writeNumber(numberOfEdges);
+    writer.writeChar('\n');
+    for (std::uint64_t id: finalGraph.nodeIds) {
+        writer.writeNumber(id);
+        writer.writeChar('\n');
     }
-    for (const auto &item: intermediateGraph->edges) {
-        FinalEdge* edge = new FinalEdge{item->id, item->startNode->id, item->endNode->id};
-        finalGraph->edges.push_back(edge);
+    for (std::uint64_t i = 0; i < finalGraph.numberOfEdges(); ++i) {
+        if (!redundancyBitmap.empty() && (redundancyBitmap[i / 64] & (std::uint64_t(1) << (i % 64)))) {
+            continue;
+        }
+        writer.writeNumber(finalGraph.edgeIds[i]);
+        writer.writeChar(' ');
+        writer.writeNumber(finalGraph.edgeStartNodeIds[i]);
+        writer.writeChar(' ');
+        writer.writeNumber(finalGraph.edgeEndNodeIds[i]);
+        writer.writeChar('\n');
     }
-    return finalGraph;
+}
+
+void GraphParser::exportFinalGraph(FinalGraphView finalGraph, std::string title, OutputCompression compression) {
+    BufferedWriter writer(title, compression);
+    writeTextGraph(writer, finalGraph, {}, finalGraph.numberOfEdges());
+    writer.close();
+}
+
+FinalGraph GraphParser::importFinalGraph(std::string title) {
+    FinalGraph graph;
+    scanFinalGraph(title,
+                   [&graph](std::uint64_t numberOfNodes, std::uint64_t numberOfEdges) {
+                       graph.reserve(numberOfNodes, numberOfEdges);
+                   },
+                   [&graph](const FinalNode &node) {
+                       graph.addNode(node);
+                   },
+                   [&graph](const FinalEdge &edge) {
+                       graph.addEdge(edge);
+                   });
+    return graph;
 }
 
 /**
- * split the string into vector of strings based on given delimiter
+ * parse the unsigned integer fields of a line into the given array, return the number of parsed fields
  */
-std::vector<std::string> split(std::string s, std::string delimiter) {
-    size_t pos_start = 0, pos_end, delim_len = delimiter.length();
-    std::string token;
-    std::vector<std::string> res;
-
-    while ((pos_end = s.find(delimiter, pos_start)) != std::string::npos) {
-        token = s.substr(pos_start, pos_end - pos_start);
-        pos_start = pos_end + delim_len;
-        res.push_back(token);
-    }
-
-    res.push_back(s.substr(pos_start));
-    return res;
-}
-
-void GraphParser::exportFinalGraph(FinalGraph* finalGraph, std::string title) {
-    std::ofstream file(title);
-    file << finalGraph->nodes.size()
-         << " "
-         << finalGraph->edges.size()
-         << std::endl;
-    for (const auto &item: finalGraph->nodes) {
-        file << item->id
-             << std::endl;
-    }
-    for (const auto &item: finalGraph->edges) {
-        file << item->id
-             << " "
-             << item->startNodeId
-             << " "
-             << item->endNodeId
-             << std::endl;
+static std::size_t parseFields(const std::string &line, std::uint64_t* fields, std::size_t maxFields) {
+    const char* current = line.data();
+    const char* end = line.data() + line.size();
+    std::size_t count = 0;
+    while (count < maxFields) {
+        while (current < end && *current == ' ') {
+            current++;
+        }
+        auto [next, error] = std::from_chars(current, end, fields[count]);
+        if (error != std::errc()) {
+            break;
+        }
+        current = next;
+        count++;
     }
-    file.close();
+    return count;
 }
 
-FinalGraph* GraphParser::importFinalGraph(std::string title) {
-    FinalGraph* graph = new FinalGraph();
+void GraphParser::scanFinalGraph(std::string title,
+                                 const std::function<void(std::uint64_t, std::uint64_t)> &onHeader,
+                                 const std::function<void(const FinalNode &)> &onNode,
+                                 const std::function<void(const FinalEdge &)> &onEdge) {
     std::ifstream file(title);
+    if (!file) {
+        throw std::runtime_error("Cannot open graph file " + title);
+    }
     std::string line;
+    std::uint64_t fields[3] = {0, 0, 0};
     getline(file, line);
-    auto header = split(line, " ");
-    int numberOfNodes = std::atoi(header[0].c_str());
-    int numberOfEdges = std::atoi(header[1].c_str());
-    for (int i = 0; i < numberOfNodes; ++i) {
-        FinalNode* node = new FinalNode();
-        std::string nodeLine;
-        getline(file, nodeLine);
-        node->id = std::atoi(nodeLine.c_str());
-        graph->nodes.push_back(node);
-    }
-    for (int i = 0; i < numberOfEdges; ++i) {
-        FinalEdge* edge = new FinalEdge();
-        std::string edgeLine;
-        getline(file, edgeLine);
-        auto edgeFields = split(edgeLine, " ");
-        edge->id = std::atoi(edgeFields[0].c_str());
-        edge->startNodeId = std::atoi(edgeFields[1].c_str());
-        edge->endNodeId = std::atoi(edgeFields[2].c_str());
-        graph->edges.push_back(edge);
+    if (parseFields(line, fields, 2) != 2) {
+        throw std::runtime_error("Malformed header in graph file " + title);
+    }
+    std::uint64_t numberOfNodes = fields[0];
+    std::uint64_t numberOfEdges = fields[1];
+    onHeader(numberOfNodes, numberOfEdges);
+    for (std::uint64_t i = 0; i < numberOfNodes; ++i) {
+        getline(file, line);
+        if (parseFields(line, fields, 1) != 1) {
+            throw std::runtime_error("Malformed node in graph file " + title);
+        }
+        onNode(FinalNode{fields[0]});
+    }
+    for (std::uint64_t i = 0; i < numberOfEdges; ++i) {
+        getline(file, line);
+        if (parseFields(line, fields, 3) != 3) {
+            throw std::runtime_error("Malformed edge in graph file " + title);
+        }
+        onEdge(FinalEdge{fields[0], fields[1], fields[2]});
     }
     file.close();
+}
+
+static constexpr char graphMagic[8] = {'T', 'R', 'G', 'R', 'A', 'P', 'H', '1'};
+static constexpr char bitmapMagic[8] = {'T', 'R', 'B', 'I', 'T', 'M', 'P', '1'};
+
+/**
+ * write the words of values whose edge is not marked in redundancyBitmap
+ */
+static void writeKeptWords(BufferedWriter &writer, std::span<const std::uint64_t> values,
+                           const std::vector<std::uint64_t> &redundancyBitmap) {
+    for (std::size_t i = 0; i < values.size(); ++i) {
+        if (!(redundancyBitmap[i / 64] & (std::uint64_t(1) << (i % 64)))) {
+            writer.writeWords(&values[i], 1);
+        }
+    }
+}
+
+static std::uint64_t countBits(const std::vector<std::uint64_t> &bitmap) {
+    return BitKernels::popcount(bitmap.data(), bitmap.size());
+}
+
+void GraphParser::exportFinalGraphBinary(FinalGraphView finalGraph, std::string title,
+                                         OutputCompression compression) {
+    BufferedWriter writer(title, compression);
+    std::uint64_t header[2] = {finalGraph.numberOfNodes(), finalGraph.numberOfEdges()};
+    writer.writeBytes(graphMagic, sizeof(graphMagic));
+    writer.writeWords(header, 2);
+    writer.writeWords(finalGraph.nodeIds.data(), finalGraph.nodeIds.size());
+    writer.writeWords(finalGraph.edgeIds.data(), finalGraph.edgeIds.size());
+    writer.writeWords(finalGraph.edgeStartNodeIds.data(), finalGraph.edgeStartNodeIds.size());
+    writer.writeWords(finalGraph.edgeEndNodeIds.data(), finalGraph.edgeEndNodeIds.size());
+    writer.close();
+}
+
+FinalGraph GraphParser::importFinalGraphBinary(std::string title) {
+    std::ifstream file(title, std::ios::binary);
+    char magic[8];
+    std::uint64_t header[2];
+    file.read(magic, sizeof(magic));
+    file.read(reinterpret_cast<char*>(header), sizeof(header));
+    if (!file || !std::equal(magic, magic + sizeof(magic), graphMagic)) {
+        throw std::runtime_error("Not a binary graph file " + title);
+    }
+    FinalGraph graph;
+    auto readWords = [&file](std::vector<std::uint64_t> &words, std::uint64_t count) {
+        words.resize(count);
+        file.read(reinterpret_cast<char*>(words.data()), static_cast<std::streamsize>(count * sizeof(std::uint64_t)));
+    };
+    readWords(graph.nodeIds, header[0]);
+    readWords(graph.edgeIds, header[1]);
+    readWords(graph.edgeStartNodeIds, header[1]);
+    readWords(graph.edgeEndNodeIds, header[1]);
+    if (!file) {
+        throw std::runtime_error("Truncated binary graph file " + title);
+    }
     return graph;
 }
 
+FinalGraph GraphParser::importFinalGraph(std::string title, GraphFileFormat format) {
+    return format == GraphFileFormat::Binary ? importFinalGraphBinary(std::move(title))
+                                             : importFinalGraph(std::move(title));
+}
+
+void GraphParser::scanFinalGraphBinary(std::string title,
+                                       const std::function<void(std::uint64_t, std::uint64_t)> &onHeader,
+                                       const std::function<void(const FinalNode &)> &onNode,
+                                       const std::function<void(const FinalEdge &)> &onEdge) {
+    std::ifstream file(title, std::ios::binary);
+    char magic[8];
+    std::uint64_t header[2];
+    file.read(magic, sizeof(magic));
+    file.read(reinterpret_cast<char*>(header), sizeof(header));
+    if (!file || !std::equal(magic, magic + sizeof(magic), graphMagic)) {
+        throw std::runtime_error("Not a binary graph file " + title);
+    }
+    std::uint64_t numberOfNodes = header[0];
+    std::uint64_t numberOfEdges = header[1];
+    onHeader(numberOfNodes, numberOfEdges);
+
+    // one sequential reader per array: node ids, edge ids, start node ids and end node ids
+    constexpr std::uint64_t blockWords = 1 << 12;
+    struct ArrayReader {
+        std::ifstream file;
+        std::vector<std::uint64_t> block;
+        std::uint64_t next = 0;
+        std::uint64_t remaining = 0;
+    };
+    std::uint64_t arrayOffset = sizeof(magic) + sizeof(header);
+    std::uint64_t lengths[4] = {numberOfNodes, numberOfEdges, numberOfEdges, numberOfEdges};
+    ArrayReader readers[4];
+    for (int array = 0; array < 4; ++array) {
+        readers[array].file.open(title, std::ios::binary);
+        readers[array].file.seekg(static_cast<std::streamoff>(arrayOffset));
+        readers[array].remaining = lengths[array];
+        arrayOffset += lengths[array] * sizeof(std::uint64_t);
+    }
+    auto nextWord = [&title, blockWords](ArrayReader &reader) {
+        if (reader.next == reader.block.size()) {
+            reader.block.resize(std::min(blockWords, reader.remaining));
+            reader.file.read(reinterpret_cast<char*>(reader.block.data()),
+                             static_cast<std::streamsize>(reader.block.size() * sizeof(std::uint64_t)));
+            if (!reader.file) {
+                throw std::runtime_error("Truncated binary graph file " + title);
+            }
+            reader.remaining -= reader.block.size();
+            reader.next = 0;
+        }
+        return reader.block[reader.next++];
+    };
+    for (std::uint64_t i = 0; i < numberOfNodes; ++i) {
+        onNode(FinalNode{nextWord(readers[0])});
+    }
+    for (std::uint64_t i = 0; i < numberOfEdges; ++i) {
+        std::uint64_t id = nextWord(readers[1]);
+        std::uint64_t startNodeId = nextWord(readers[2]);
+        onEdge(FinalEdge{id, startNodeId, nextWord(readers[3])});
+    }
+}
+
+void GraphParser::scanFinalGraph(std::string title, GraphFileFormat format,
+                                 const std::function<void(std::uint64_t, std::uint64_t)> &onHeader,
+                                 const std::function<void(const FinalNode &)> &onNode,
+                                 const std::function<void(const FinalEdge &)> &onEdge) {
+    if (format == GraphFileFormat::Binary) {
+        scanFinalGraphBinary(std::move(title), onHeader, onNode, onEdge);
+    } else {
+        scanFinalGraph(std::move(title), onHeader, onNode, onEdge);
+    }
+}
+
+GraphFileFormat GraphParser::detectGraphFileFormat(const std::string &title) {
+    std::ifstream file(title, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Cannot open graph file " + title);
+    }
+    char magic[sizeof(graphMagic)] = {};
+    file.read(magic, sizeof(magic));
+    return file && std::equal(magic, magic + sizeof(magic), graphMagic) ? GraphFileFormat::Binary
+                                                                        : GraphFileFormat::Text;
+}
+
+std::vector<std::uint64_t> GraphParser::packRedundancyBitmap(const IntermediateGraph* intermediateGraph,
+                                                             ReductionAlgorithm algorithm) {
+    std::vector<std::uint64_t> bitmap((intermediateGraph->edges.size() + 63) / 64, 0);
+    for (std::size_t i = 0; i < intermediateGraph->edges.size(); ++i) {
+        const IntermediateEdge* edge = intermediateGraph->edges[i];
+        bool isRedundant = algorithm == ReductionAlgorithm::DFS ? edge->isRedundant_DFS : edge->isRedundant_TROPlus;
+        if (isRedundant) {
+            bitmap[i / 64] |= std::uint64_t(1) << (i % 64);
+        }
+    }
+    return bitmap;
+}
+
+void GraphParser::exportReducedGraph(const IntermediateGraph* intermediateGraph, ReductionAlgorithm algorithm,
+                                     std::string title, GraphFileFormat format, OutputCompression compression) {
+    exportReducedGraph(parseToFinalGraph(intermediateGraph), packRedundancyBitmap(intermediateGraph, algorithm),
+                       std::move(title), format, compression);
+}
+
+void GraphParser::exportReducedGraph(FinalGraphView graph, const std::vector<std::uint64_t> &redundancyBitmap,
+                                     std::string title, GraphFileFormat format, OutputCompression compression) {
+    BufferedWriter writer(title, compression);
+    writeReducedGraph(writer, graph, redundancyBitmap, format);
+    writer.close();
+}
+
+void GraphParser::writeReducedGraph(BufferedWriter &writer, const IntermediateGraph* intermediateGraph,
+                                    ReductionAlgorithm algorithm, GraphFileFormat format) {
+    writeReducedGraph(writer, parseToFinalGraph(intermediateGraph), packRedundancyBitmap(intermediateGraph, algorithm),
+                      format);
+}
+
+void GraphParser::writeReducedGraph(BufferedWriter &writer, FinalGraphView graph,
+                                    const std::vector<std::uint64_t> &redundancyBitmap, GraphFileFormat format) {
+    std::uint64_t numberOfKeptEdges = graph.numberOfEdges() - countBits(redundancyBitmap);
+
+    if (format == GraphFileFormat::Binary) {
+        std::uint64_t header[2] = {graph.numberOfNodes(), numberOfKeptEdges};
+        writer.writeBytes(graphMagic, sizeof(graphMagic));
+        writer.writeWords(header, 2);
+        writer.writeWords(graph.nodeIds.data(), graph.nodeIds.size());
+        writeKeptWords(writer, graph.edgeIds, redundancyBitmap);
+        writeKeptWords(writer, graph.edgeStartNodeIds, redundancyBitmap);
+        writeKeptWords(writer, graph.edgeEndNodeIds, redundancyBitmap);
+    } else {
+        writeTextGraph(writer, graph, redundancyBitmap, numberOfKeptEdges);
+    }
+}
+
+void GraphParser::exportRedundancyBitmap(const IntermediateGraph* intermediateGraph, ReductionAlgorithm algorithm,
+                                         std::string title, GraphFileFormat format) {
+    exportRedundancyBitmap(packRedundancyBitmap(intermediateGraph, algorithm), intermediateGraph->edges.size(),
+                           std::move(title), format);
+}
+
+void GraphParser::exportRedundancyBitmap(const std::vector<std::uint64_t> &redundancyBitmap,
+                                         std::uint64_t numberOfEdges, std::string title, GraphFileFormat format) {
+    std::uint64_t header[2] = {numberOfEdges, countBits(redundancyBitmap)};
+    BufferedWriter writer(title);
+
+    if (format == GraphFileFormat::Binary) {
+        writer.writeBytes(bitmapMagic, sizeof(bitmapMagic));
+        writer.writeWords(header, 2);
+        writer.writeWords(redundancyBitmap.data(), redundancyBitmap.size());
+    } else {
+        writer.writeNumber(header[0]);
+        writer.writeChar(' ');
+        writer.writeNumber(header[1]);
+        writer.writeChar('\n');
+        for (std::uint64_t word: redundancyBitmap) {
+            writer.writeHex(word, 16);
+            writer.writeChar('\n');
+        }
+    }
+    writer.close();
+}
+
+std::vector<std::uint64_t> GraphParser::importRedundancyBitmap(std::string title, GraphFileFormat format,
+                                                               std::uint64_t &numberOfEdges) {
+    std::vector<std::uint64_t> redundancyBitmap;
+    if (format == GraphFileFormat::Binary) {
+        std::ifstream file(title, std::ios::binary);
+        char magic[8];
+        std::uint64_t header[2];
+        file.read(magic, sizeof(magic));
+        file.read(reinterpret_cast<char*>(header), sizeof(header));
+        if (!file || !std::equal(magic, magic + sizeof(magic), bitmapMagic)) {
+            throw std::runtime_error("Not a binary redundancy bitmap " + title);
+        }
+        numberOfEdges = header[0];
+        redundancyBitmap.resize((numberOfEdges + 63) / 64);
+        file.read(reinterpret_cast<char*>(redundancyBitmap.data()),
+                  static_cast<std::streamsize>(redundancyBitmap.size() * sizeof(std::uint64_t)));
+        if (!file) {
+            throw std::runtime_error("Truncated redundancy bitmap " + title);
+        }
+        return redundancyBitmap;
+    }
+
+    std::ifstream file(title);
+    std::string line;
+    std::uint64_t header[2];
+    getline(file, line);
+    if (parseFields(line, header, 2) != 2) {
+        throw std::runtime_error("Malformed header in redundancy bitmap " + title);
+    }
+    numberOfEdges = header[0];
+    redundancyBitmap.resize((numberOfEdges + 63) / 64);
+    for (std::uint64_t &word: redundancyBitmap) {
+        getline(file, line);
+        auto [end, error] = std::from_chars(line.data(), line.data() + line.size(), word, 16);
+        if (error != std::errc()) {
+            throw std::runtime_error("Malformed word in redundancy bitmap " + title);
+        }
+    }
+    return redundancyBitmap;
+}
@@ -8,9 +8,23 @@
 #define ALGORITHMPROJECT_GRAPHPARSER_H
 
 
+#include <functional>
+#include <memory>
+#include <string>
+#include "BufferedWriter.h"
 #include "IntermediateGraph.h"
 #include "FinalGraph.h"
 
+/**
+ * @brief on-disk representation of graphs and reduction results
+ */
+enum class GraphFileFormat {
+    // human readable, one record per line
+    Text,
+    // fixed width native-endian words, see exportFinalGraphBinary and exportRedundancyBitmap
+    Binary
+};
+
 class GraphParser {
 public:
     /**
@@ -18,33 +32,37 @@ public:
      *
      * This method creates an IntermediateGraph from a given FinalGraph. It maps nodes and edges from the FinalGraph
      * to their corresponding IntermediateGraph representations, maintaining the graph structure and connections.
+     * The FinalGraph arrays are moved into the IntermediateGraph rather than copied.
      *
-     * @param finalGraph Pointer to the input FinalGraph
-     * @return Pointer to the newly created IntermediateGraph
+     * @param finalGraph The input FinalGraph, moved from
+     * @return The newly created IntermediateGraph, which owns all of its nodes and edges
      */
-    static IntermediateGraph* parseToIntermediateGraph(FinalGraph* finalGraph);
+    static std::unique_ptr<IntermediateGraph> parseToIntermediateGraph(FinalGraph &&finalGraph);
 
     /**
      * @brief Converts an IntermediateGraph to a FinalGraph.
      *
-     * This method creates a FinalGraph from a given IntermediateGraph. It maps nodes and edges from the IntermediateGraph
-     * to their corresponding FinalGraph representations, preserving the graph structure.
+     * This method returns a view of the FinalGraph the IntermediateGraph was parsed from. Nodes and edges are
+     * in the same order as in the IntermediateGraph, and nothing is copied.
      *
-     * @param intermediateGraph Pointer to the input IntermediateGraph
-     * @return Pointer to the newly created FinalGraph
+     * @param intermediateGraph Pointer to the input IntermediateGraph, which must outlive the returned view
+     * @return View of the graph in FinalGraph layout
      */
-    static FinalGraph* parseToFinalGraph(IntermediateGraph* intermediateGraph);
+    static FinalGraphView parseToFinalGraph(const IntermediateGraph* intermediateGraph);
 
     /**
      * @brief Exports a FinalGraph to a txt file.
      *
      * This method writes the structure of a FinalGraph to a file. The file format includes the number of nodes and edges,
-     * followed by node IDs and edge details (ID, measureGraphTRTime node ID, end node ID).
+     * followed by node IDs and edge details (ID, start node ID, end node ID). Records go through a BufferedWriter,
+     * so the file is written in a few large chunks.
      *
-     * @param finalGraph Pointer to the FinalGraph to be exported
+     * @param finalGraph View of the FinalGraph to be exported
      * @param title The filename to write the graph data to
+     * @param compression Optional zstd or lz4 framing of the whole file
      */
-    static void exportFinalGraph(FinalGraph* finalGraph, std::string title);
+    static void exportFinalGraph(FinalGraphView finalGraph, std::string title,
+                                 OutputCompression compression = OutputCompression::None);
 
     /**
      * @brief Imports a FinalGraph from a txt file.
@@ -53,9 +71,159 @@ public:
      * The file should be in the format produced by the exportFinalGraph method.
      *
      * @param title The filename to read the graph data from
-     * @return Pointer to the newly created FinalGraph
+     * @return The imported FinalGraph
+     */
+    static FinalGraph importFinalGraph(std::string title);
+
+    /**
+     * @brief Streams a FinalGraph from a txt file without materializing it.
+     *
+     * This method reads the same format as importFinalGraph, but hands every record to the given callbacks as soon
+     * as it is parsed instead of collecting them into a FinalGraph. It is used by the out-of-core reducer
+     * for graphs that do not fit in memory.
+     *
+     * @param title The filename to read the graph data from
+     * @param onHeader Called once with the number of nodes and edges
+     * @param onNode Called for every node in file order
+     * @param onEdge Called for every edge in file order
+     */
+    static void scanFinalGraph(std::string title,
+                               const std::function<void(std::uint64_t, std::uint64_t)> &onHeader,
+                               const std::function<void(const FinalNode &)> &onNode,
+                               const std::function<void(const FinalEdge &)> &onEdge);
+
+    /**
+     * @brief Exports a FinalGraph to a binary file.
+     *
+     * The file starts with the 8 byte magic "TRGRAPH1", the number of nodes and the number of edges, followed by
+     * the node id array, the edge id array, the start node id array and the end node id array of the FinalGraph.
+     * All values are 64-bit words in native byte order, so the arrays can be read back without parsing.
+     *
+     * @param finalGraph View of the FinalGraph to be exported
+     * @param title The filename to write the graph data to
+     * @param compression Optional zstd or lz4 framing of the whole file
+     */
+    static void exportFinalGraphBinary(FinalGraphView finalGraph, std::string title,
+                                       OutputCompression compression = OutputCompression::None);
+
+    /**
+     * @brief Appends the transitive reduction computed on an IntermediateGraph to an open writer, in the same
+     * layout as exportReducedGraph. Used to stream several reduced graphs into one file.
+     */
+    static void writeReducedGraph(BufferedWriter &writer, const IntermediateGraph* intermediateGraph,
+                                  ReductionAlgorithm algorithm, GraphFileFormat format);
+
+    /**
+     * @brief Appends a graph without the edges set in a redundancy bitmap to an open writer, in the same layout as
+     * exportReducedGraph. Used for the results of a TransitiveReducer, see ReductionWorkspace::redundancyBitmap.
+     */
+    static void writeReducedGraph(BufferedWriter &writer, FinalGraphView graph,
+                                  const std::vector<std::uint64_t> &redundancyBitmap, GraphFileFormat format);
+
+    /**
+     * @brief Imports a FinalGraph from a binary file written by exportFinalGraphBinary.
+     *
+     * @param title The filename to read the graph data from
+     * @return The imported FinalGraph
+     */
+    static FinalGraph importFinalGraphBinary(std::string title);
+
+    /**
+     * @brief Streams a FinalGraph from a binary file written by exportFinalGraphBinary, with the callbacks of
+     * scanFinalGraph. The edge arrays are read through one buffer each, so memory stays constant.
+     */
+    static void scanFinalGraphBinary(std::string title,
+                                     const std::function<void(std::uint64_t, std::uint64_t)> &onHeader,
+                                     const std::function<void(const FinalNode &)> &onNode,
+                                     const std::function<void(const FinalEdge &)> &onEdge);
+
+    /**
+     * @brief Streams a FinalGraph in the given format, see scanFinalGraph.
+     */
+    static void scanFinalGraph(std::string title, GraphFileFormat format,
+                               const std::function<void(std::uint64_t, std::uint64_t)> &onHeader,
+                               const std::function<void(const FinalNode &)> &onNode,
+                               const std::function<void(const FinalEdge &)> &onEdge);
+
+    /**
+     * @brief Imports a FinalGraph in the given format.
+     */
+    static FinalGraph importFinalGraph(std::string title, GraphFileFormat format);
+
+    /**
+     * @brief Detects the format of a graph file by its magic, Binary if it starts with "TRGRAPH1", Text otherwise.
+     */
+    static GraphFileFormat detectGraphFileFormat(const std::string &title);
+
+    /**
+     * @brief Exports the transitive reduction computed on an IntermediateGraph.
+     *
+     * All nodes are written, edges only if the given algorithm did not mark them redundant. Edges keep their input
+     * order. The text format is the one of exportFinalGraph and the binary format the one of exportFinalGraphBinary.
+     *
+     * @param intermediateGraph Pointer to the IntermediateGraph the algorithm ran on
+     * @param algorithm The algorithm whose redundancy marks are used
+     * @param title The filename to write the reduced graph to
+     * @param format Text or binary output
+     * @param compression Optional zstd or lz4 framing of the whole file
+     */
+    static void exportReducedGraph(const IntermediateGraph* intermediateGraph, ReductionAlgorithm algorithm,
+                                   std::string title, GraphFileFormat format,
+                                   OutputCompression compression = OutputCompression::None);
+
+    /**
+     * @brief Exports a graph without the edges set in a redundancy bitmap, in the layout of the overload above.
+     *
+     * @param graph The graph that was reduced
+     * @param redundancyBitmap One bit per edge of graph, as packed by packRedundancyBitmap
+     */
+    static void exportReducedGraph(FinalGraphView graph, const std::vector<std::uint64_t> &redundancyBitmap,
+                                   std::string title, GraphFileFormat format,
+                                   OutputCompression compression = OutputCompression::None);
+
+    /**
+     * @brief Packs the redundancy marks of an algorithm into a bitmap with one bit per edge.
+     *
+     * Bit i % 64 of word i / 64 is set iff edge i of the input edge order is redundant.
+     *
+     * @param intermediateGraph Pointer to the IntermediateGraph the algorithm ran on
+     * @param algorithm The algorithm whose redundancy marks are packed
+     * @return The packed bitmap, (number of edges + 63) / 64 words
+     */
+    static std::vector<std::uint64_t> packRedundancyBitmap(const IntermediateGraph* intermediateGraph,
+                                                           ReductionAlgorithm algorithm);
+
+    /**
+     * @brief Exports the redundancy marks of an algorithm as a packed bitmap aligned with the input edge order.
+     *
+     * The text format is a line with the number of edges and the number of redundant edges, followed by one
+     * bitmap word per line as 16 hex digits. The binary format is the 8 byte magic "TRBITMP1", the number of edges,
+     * the number of redundant edges and the bitmap words, all 64-bit native byte order.
+     *
+     * @param intermediateGraph Pointer to the IntermediateGraph the algorithm ran on
+     * @param algorithm The algorithm whose redundancy marks are exported
+     * @param title The filename to write the bitmap to
+     * @param format Text or binary output
+     */
+    static void exportRedundancyBitmap(const IntermediateGraph* intermediateGraph, ReductionAlgorithm algorithm,
+                                       std::string title, GraphFileFormat format);
+
+    /**
+     * @brief Exports a packed redundancy bitmap covering numberOfEdges edges, in the layout of the overload above.
+     */
+    static void exportRedundancyBitmap(const std::vector<std::uint64_t> &redundancyBitmap,
+                                       std::uint64_t numberOfEdges, std::string title, GraphFileFormat format);
+
+    /**
+     * @brief Imports a redundancy bitmap written by exportRedundancyBitmap.
+     *
+     * @param title The filename to read the bitmap from
+     * @param format The format the bitmap was written in
+     * @param numberOfEdges Set to the number of edges the bitmap covers
+     * @return The packed bitmap
      */
-    static FinalGraph* importFinalGraph(std::string title);
+    static std::vector<std::uint64_t> importRedundancyBitmap(std::string title, GraphFileFormat format,
+                                                             std::uint64_t &numberOfEdges);
 };
 
 
@@ -0,0 +1,214 @@
+//
+// GraphReorderer renumbers nodes and edges of a graph for memory locality in the reduction engine
+//
+
+#include "GraphReorderer.h"
+#include <algorithm>
+#include <numeric>
+#include <utility>
+
+
+/**
+ * Kahn's algorithm, the order doubles as the FIFO queue
+ */
+template<typename Index>
+static std::vector<std::uint64_t> topologicalOrder(const BasicReductionGraph<Index> &graph) {
+    std::uint64_t numberOfNodes = graph.numberOfNodes();
+    std::vector<std::uint64_t> inDegrees(numberOfNodes);
+    std::vector<std::uint64_t> order;
+    order.reserve(numberOfNodes);
+    for (std::uint64_t node = 0; node < numberOfNodes; ++node) {
+        inDegrees[node] = graph.inDegree(node);
+        if (inDegrees[node] == 0) {
+            order.push_back(node);
+        }
+    }
+    for (std::uint64_t i = 0; i < order.size(); ++i) {
+        for (std::uint64_t edge: graph.outgoingEdges(order[i])) {
+            if (--inDegrees[graph.edgeEnd(edge)] == 0) {
+                order.push_back(graph.edgeEnd(edge));
+            }
+        }
+    }
+    // nodes on or behind a cycle never reach in-degree 0
+    for (std::uint64_t node = 0; node < numberOfNodes && order.size() < numberOfNodes; ++node) {
+        if (inDegrees[node] > 0) {
+            order.push_back(node);
+        }
+    }
+    return order;
+}
+
+template<typename Index>
+static std::vector<std::uint64_t> dfsPostOrder(const BasicReductionGraph<Index> &graph) {
+    std::uint64_t numberOfNodes = graph.numberOfNodes();
+    std::vector<std::uint64_t> order;
+    order.reserve(numberOfNodes);
+    std::vector<std::uint8_t> isVisited(numberOfNodes, 0);
+    // nodes on the DFS path and the position of the next outgoing edge to follow
+    std::vector<std::pair<std::uint64_t, std::uint64_t>> stack;
+    auto visit = [&](std::uint64_t root) {
+        if (isVisited[root]) {
+            return;
+        }
+        isVisited[root] = 1;
+        stack.emplace_back(root, 0);
+        while (!stack.empty()) {
+            std::uint64_t node = stack.back().first;
+            auto outgoingEdges = graph.outgoingEdges(node);
+            if (stack.back().second == outgoingEdges.size()) {
+                order.push_back(node);
+                stack.pop_back();
+                continue;
+            }
+            std::uint64_t endNode = graph.edgeEnd(outgoingEdges[stack.back().second++]);
+            if (!isVisited[endNode]) {
+                isVisited[endNode] = 1;
+                stack.emplace_back(endNode, 0);
+            }
+        }
+    };
+    for (std::uint64_t node: graph.getStartingNodes()) {
+        visit(node);
+    }
+    // cycles without a node of in-degree 0
+    for (std::uint64_t node = 0; node < numberOfNodes; ++node) {
+        visit(node);
+    }
+    return order;
+}
+
+/**
+ * breadth-first search over the undirected graph from a node of minimum degree in every component, neighbours
+ * in increasing degree, then reversed
+ */
+template<typename Index>
+static std::vector<std::uint64_t> reverseCuthillMcKeeOrder(const BasicReductionGraph<Index> &graph) {
+    std::uint64_t numberOfNodes = graph.numberOfNodes();
+    auto degree = [&graph](std::uint64_t node) {
+        return graph.inDegree(node) + graph.outDegree(node);
+    };
+    auto isLowerDegree = [&degree](std::uint64_t a, std::uint64_t b) {
+        return std::make_pair(degree(a), a) < std::make_pair(degree(b), b);
+    };
+    std::vector<std::uint64_t> roots(numberOfNodes);
+    std::iota(roots.begin(), roots.end(), 0);
+    std::sort(roots.begin(), roots.end(), isLowerDegree);
+    std::vector<std::uint64_t> order;
+    order.reserve(numberOfNodes);
+    std::vector<std::uint8_t> isVisited(numberOfNodes, 0);
+    std::vector<std::uint64_t> neighbours;
+    for (std::uint64_t root: roots) {
+        if (isVisited[root]) {
+            continue;
+        }
+        isVisited[root] = 1;
+        order.push_back(root);
+        for (std::uint64_t i = order.size() - 1; i < order.size(); ++i) {
+            neighbours.clear();
+            auto add = [&](std::uint64_t neighbour) {
+                if (!isVisited[neighbour]) {
+                    isVisited[neighbour] = 1;
+                    neighbours.push_back(neighbour);
+                }
+            };
+            for (std::uint64_t edge: graph.outgoingEdges(order[i])) {
+                add(graph.edgeEnd(edge));
+            }
+            for (std::uint64_t edge: graph.incomingEdges(order[i])) {
+                add(graph.edgeStart(edge));
+            }
+            std::sort(neighbours.begin(), neighbours.end(), isLowerDegree);
+            order.insert(order.end(), neighbours.begin(), neighbours.end());
+        }
+    }
+    std::reverse(order.begin(), order.end());
+    return order;
+}
+
+template<typename Index>
+std::vector<std::uint64_t> GraphReorderer::computeOrder(const BasicReductionGraph<Index> &graph,
+                                                        NodeOrdering ordering) {
+    switch (ordering) {
+        case NodeOrdering::Topological:
+            return topologicalOrder(graph);
+        case NodeOrdering::DFSPostOrder:
+            return dfsPostOrder(graph);
+        case NodeOrdering::ReverseCuthillMcKee:
+            return reverseCuthillMcKeeOrder(graph);
+        case NodeOrdering::Input:
+            break;
+    }
+    std::vector<std::uint64_t> order(graph.numberOfNodes());
+    std::iota(order.begin(), order.end(), 0);
+    return order;
+}
+
+template std::vector<std::uint64_t> GraphReorderer::computeOrder(const ReductionGraph &, NodeOrdering);
+template std::vector<std::uint64_t> GraphReorderer::computeOrder(const WideReductionGraph &, NodeOrdering);
+
+template<typename Index>
+static ReorderedGraph reorderWith(const FinalGraph &graph, NodeOrdering ordering) {
+    BasicReductionGraph<Index> reductionGraph(graph.view());
+    std::uint64_t numberOfNodes = reductionGraph.numberOfNodes();
+    std::uint64_t numberOfEdges = reductionGraph.numberOfEdges();
+    std::vector<std::uint64_t> order = GraphReorderer::computeOrder(reductionGraph, ordering);
+    std::vector<std::uint64_t> positions(numberOfNodes);
+    for (std::uint64_t position = 0; position < numberOfNodes; ++position) {
+        positions[order[position]] = position;
+    }
+
+    // two stable counting sorts: the incoming edges of the nodes in new order are sorted by end position, then
+    // bucketing them by start position sorts by start, end and input edge order
+    std::vector<std::uint64_t> byEnd;
+    byEnd.reserve(numberOfEdges);
+    for (std::uint64_t node: order) {
+        auto incomingEdges = reductionGraph.incomingEdges(node);
+        byEnd.insert(byEnd.end(), incomingEdges.begin(), incomingEdges.end());
+    }
+    std::vector<std::uint64_t> startOffsets(numberOfNodes + 1, 0);
+    for (std::uint64_t position = 0; position < numberOfNodes; ++position) {
+        startOffsets[position + 1] = startOffsets[position] + reductionGraph.outDegree(order[position]);
+    }
+    ReorderedGraph reordered;
+    reordered.inputEdges.resize(numberOfEdges);
+    for (std::uint64_t edge: byEnd) {
+        reordered.inputEdges[startOffsets[positions[reductionGraph.edgeStart(edge)]]++] = edge;
+    }
+
+    FinalGraph &result = reordered.graph;
+    result.reserve(numberOfNodes, numberOfEdges);
+    for (std::uint64_t node: order) {
+        result.addNode({graph.nodeIds[node]});
+    }
+    for (std::uint64_t edge: reordered.inputEdges) {
+        result.addEdge(graph.edge(edge));
+    }
+    return reordered;
+}
+
+ReorderedGraph GraphReorderer::reorder(const FinalGraph &graph, NodeOrdering ordering) {
+    if (ordering == NodeOrdering::Input) {
+        ReorderedGraph reordered{graph, std::vector<std::uint64_t>(graph.numberOfEdges())};
+        std::iota(reordered.inputEdges.begin(), reordered.inputEdges.end(), 0);
+        return reordered;
+    }
+    if (ReductionGraph::fits(graph.numberOfNodes(), graph.numberOfEdges())) {
+        return reorderWith<std::uint32_t>(graph, ordering);
+    }
+    return reorderWith<std::uint64_t>(graph, ordering);
+}
+
+std::string GraphReorderer::orderingName(NodeOrdering ordering) {
+    switch (ordering) {
+        case NodeOrdering::Input:
+            return "input";
+        case NodeOrdering::Topological:
+            return "topological";
+        case NodeOrdering::DFSPostOrder:
+            return "dfs";
+        case NodeOrdering::ReverseCuthillMcKee:
+            return "rcm";
+    }
+    return "";
+}
@@ -0,0 +1,75 @@
+/**
+ * @file GraphReorderer.h
+ * @brief This file contains GraphReorderer, which renumbers the nodes and edges of a graph so that neighbours lie
+ * close together in the arrays of the reduction engine, and maps per edge results back to the input order.
+ */
+#ifndef ALGORITHMPROJECT_GRAPHREORDERER_H
+#define ALGORITHMPROJECT_GRAPHREORDERER_H
+
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "FinalGraph.h"
+#include "TransitiveReducer.h"
+
+/**
+ * @brief the order in which GraphReorderer numbers the nodes
+ */
+enum class NodeOrdering {
+    // the order of the input file, nothing is renumbered
+    Input,
+    // Kahn's algorithm with a FIFO queue, so nodes of similar depth are close together
+    Topological,
+    // DFS post-order from the nodes without incoming edges, the order in which BFL builds its out-labels
+    DFSPostOrder,
+    // reverse Cuthill-McKee on the undirected graph, which keeps the index distance of neighbours small
+    ReverseCuthillMcKee
+};
+
+/**
+ * @brief a graph with renumbered nodes and edges. Node and edge ids are kept, only their positions change.
+ */
+struct ReorderedGraph {
+    FinalGraph graph;
+    // edge i of graph is edge inputEdges[i] of the input graph
+    std::vector<std::uint64_t> inputEdges;
+
+    /**
+     * @brief per edge values of graph, e.g. the isRedundant flags of a workspace, in the edge order of the input
+     */
+    template<typename T>
+    std::vector<T> toInputOrder(const std::vector<T> &values) const {
+        std::vector<T> inputValues(values.size());
+        for (std::uint64_t edge = 0; edge < values.size(); ++edge) {
+            inputValues[inputEdges[edge]] = values[edge];
+        }
+        return inputValues;
+    }
+};
+
+class GraphReorderer {
+public:
+    /**
+     * @brief the nodes of graph in the given order. A topological order of a graph with cycles lists the nodes on
+     * and behind them last, in input order. Instantiated for ReductionGraph and WideReductionGraph.
+     */
+    template<typename Index>
+    static std::vector<std::uint64_t> computeOrder(const BasicReductionGraph<Index> &graph, NodeOrdering ordering);
+
+    /**
+     * @brief renumber the nodes of graph in the given order and its edges by start node, then end node, so that
+     * the adjacency lists of the reduction engine are sorted by neighbour position. Parallel edges keep their
+     * input order, and NodeOrdering::Input returns a copy. Throws std::runtime_error like ReductionGraph on edges
+     * to unknown nodes.
+     */
+    static ReorderedGraph reorder(const FinalGraph &graph, NodeOrdering ordering);
+
+    /**
+     * @brief the name of an ordering as accepted by the --order option
+     */
+    static std::string orderingName(NodeOrdering ordering);
+};
+
+
+#endif //ALGORITHMPROJECT_GRAPHREORDERER_H
@@ -10,10 +10,11 @@
 
 
 #include <cstdint>
-#include <map>
+#include <span>
 #include <vector>
-#include <set>
-#include <unordered_set>
+#include "FinalGraph.h"
+#include "PhaseProfiler.h"
+#include "TransitiveReducer.h"
 
 
 class IntermediateNode;
@@ -26,7 +27,6 @@ public:
 
     bool isRedundant_DFS = false;
     bool isRedundant_TROPlus = false;
-    bool isTopoTraversed = false;
 
     explicit IntermediateEdge(std::uint64_t id) : id(id) {}
 
@@ -35,44 +35,27 @@ public:
 class IntermediateNode {
 public:
     std::uint64_t id;
-    std::vector<IntermediateEdge*> incomingEdges;
-    std::vector<IntermediateEdge*> outgoingEdges;
+    // in input edge order, views into the adjacency array of the graph
+    std::span<IntermediateEdge* const> incomingEdges;
+    std::span<IntermediateEdge* const> outgoingEdges;
 
     std::uint64_t topoOrder = 0;
-    bool isPostOrderAssigned = false;
     std::uint64_t discoverTime = 0;
     std::uint64_t finishTime = 0;
-    std::unique_ptr<std::unordered_set<uint64_t>> LabelOut = nullptr;
-    std::unique_ptr<std::unordered_set<uint64_t>> LabelIn = nullptr;
 
     explicit IntermediateNode(std::uint64_t id) : id(id) {}
 
 
 };
 
+
 /**
- * @brief hashIntermediateNode, PairHash, PairEqual is used to hash pair of hashIntermediateNode*,
- * so that it can be stored in std::unordered_set without any problems
+ * @brief object graph view of a reduction. The algorithms run on a TransitiveReducer with a workspace owned by the
+ * graph, and their results are copied back into the attributes of the nodes and edges. Every call recomputes
+ * its result from the index it queries, so algorithms and index constructions can be repeated in any order.
+ * Nodes, edges and adjacency lists are stored in a few arrays owned by the graph, the pointers in nodes, edges
+ * and startingNodes point into them and stay valid while the graph lives.
  */
-std::uint64_t hashIntermediateNode(IntermediateNode* node);
-
-struct PairHash {
-    std::size_t operator()(const std::pair<IntermediateNode*, IntermediateNode*> &p) const {
-        // Assuming your hash function for IntermediateNode is called hash_intermediate_node
-        std::size_t h1 = hashIntermediateNode(p.first);
-        std::size_t h2 = hashIntermediateNode(p.second);
-        return h1 ^ (h2 << 1);
-    }
-};
-
-struct PairEqual {
-    bool operator()(const std::pair<IntermediateNode*, IntermediateNode*> &lhs,
-                    const std::pair<IntermediateNode*, IntermediateNode*> &rhs) const {
-        return lhs.first == rhs.first && lhs.second == rhs.second;
-    }
-};
-
-
 class IntermediateGraph {
 public:
     std::vector<IntermediateNode*> startingNodes;
@@ -80,18 +63,26 @@ public:
     std::vector<IntermediateEdge*> edges;
     // <intermediateEdge, whether it's added via In-Node> Just for verification purpose
     std::vector<std::pair<IntermediateEdge*, bool>> sortedEdgePairs;
+    // the graph this one was parsed from, moved in by GraphParser. nodes[i] and edges[i] correspond to
+    // node i and edge i of it, so it can be handed back out as a FinalGraphView without a copy
+    FinalGraph source;
+    // when set, index construction, sorting and redundancy checks are recorded as phases in it
+    PhaseProfiler* profiler = nullptr;
+    // settings of the engine the algorithms run on, the algorithm and index fields are ignored. The graph never
+    // changes, so reuseSchedule is set and repeated TRO+ runs reuse the edge schedule of the first
+    ReductionOptions reductionOptions;
 
     /**
      * @brief mark the redundant edges in graph by setting edge attribute isRedundant_DFS to true.
-     * The DFS_RI is used by default, can be switched to BFL_RI in implementation.
+     * The DFS_RI is used by default, the given index must have been constructed.
      */
-    void markRedundantEdges_DFS();
+    void markRedundantEdges_DFS(ReachabilityIndex index = ReachabilityIndex::DFS_RI);
 
     /**
      * @brief mark the redundant edges in graph by setting edge attribute isRedundant_TROPlus to true.
-     * The BFL_RI is used by default, can be switched to DFS_RI in implementation.
+     * The BFL_RI is used by default, the given index must have been constructed.
      */
-    void markRedundantEdges_TROPlus(bool withVerification);
+    void markRedundantEdges_TROPlus(bool withVerification, ReachabilityIndex index = ReachabilityIndex::BFL);
 
     /**
      * @brief construct DFS_RI for reachability query
@@ -99,108 +90,48 @@ public:
     void constructDFSRI();
 
     /**
-     * @brief construct BFL_RI for reachability query
+     * @brief construct BFL_RI for reachability query, and store the DFS intervals in the nodes
      */
     void constructBFLRI();
 
-    ~IntermediateGraph() {
-        for (auto node: nodes) {
-            delete node;
-        }
-        startingNodes.clear();
-        nodes.clear();
-        for (auto edge: edges) {
-            delete edge;
-        }
-        edges.clear();
-        sortedEdgePairs.clear();
-        gMap.clear();
-        visitedInQuery.clear();
-        DFS_RI.clear();
-    }
-
-private:
-    std::uint64_t current = 0;
-    std::uint64_t numberOfIntervals = 1600;
-    std::uint64_t numberOfHashValues = 160;
-    std::map<IntermediateNode*, IntermediateNode*> gMap;
-    std::unordered_set<IntermediateNode*> visitedInQuery;
-    std::unordered_set<std::pair<IntermediateNode*, IntermediateNode*>, PairHash, PairEqual> DFS_RI;
-
     /**
-     * @brief assign topological order to all nodes in graph. Order stored in node attribute topoOrder
+     * @brief query counters since the first index construction and the current size of both indices
      */
-    void topoSort();
+    QueryStatistics getQueryStatistics() const;
 
     /**
-     * @brief recursive helper of function constructDFSRI
+     * @brief whether the core library was built with ALGORITHMPROJECT_QUERY_STATISTICS
      */
-    void dfsUtil(IntermediateNode* nodeA, IntermediateNode* nodeB);
+    static bool isCountingQueries();
 
     /**
-     * @brief recursive helper of function queryReachability_BFL
+     * @brief build the graph from finalGraph, which is moved into source. Throws std::runtime_error if an edge
+     * refers to a node id that is not in the graph.
      */
-    bool isReachable_BFL(IntermediateNode* a, IntermediateNode* b);
+    explicit IntermediateGraph(FinalGraph &&finalGraph);
 
-    /**
-     * @brief traverse tree with the given node as root, store discover time and finish time in each visited node
-     */
-    void postOrderTraverse(IntermediateNode* node);
+    IntermediateGraph(const IntermediateGraph &) = delete;
 
-    /**
-     * @brief hash a given node. The return hash value is in range of [1, intermediateGraph::numberOfHashValues]
-     */
-    std::uint64_t hash(IntermediateNode* node);
+    IntermediateGraph &operator=(const IntermediateGraph &) = delete;
 
-    /**
-     * @brief compute the BFL label of all the groups that the given node can reach
-     */
-    void computeLabelOut(IntermediateNode* node);
-
-    /**
-     * @brief compute the BFL label of all the groups that can reach the given node
-     */
-    void computeLabelIn(IntermediateNode* node);
-
-    /**
-     * @brief check whether setA is subset of setB
-     */
-    bool isSubset(const std::unique_ptr<std::unordered_set<uint64_t>> &setA,
-                  const std::unique_ptr<std::unordered_set<uint64_t>> &setB);
+private:
+    std::vector<IntermediateNode> nodeStorage;
+    std::vector<IntermediateEdge> edgeStorage;
+    // the incoming edges of all nodes followed by the outgoing edges of all nodes
+    std::vector<IntermediateEdge*> adjacencyStorage;
+    ReductionGraph reductionGraph;
+    ReductionWorkspace workspace;
 
     /**
-     * @brief check whether a can reaches b.
+     * @brief the compressed form of source, with the profiler of this graph attached to the workspace
      */
-    bool queryReachability_BFL(IntermediateNode* a, IntermediateNode* b);
+    const ReductionGraph &prepareReduction();
 
     /**
-     * @brief check if the edge is redundant and mark result by changing its attribute isRedundant_TROPlus
+     * @brief the engine with the current reductionOptions
      */
-    bool isRedundant_TROPlus(IntermediateEdge* edge);
-};
-
-
-/**
- * a class contains extra attributes for edge sorting in TRO-plus algorithm (in/out-degrees, is in/out-node).
- */
-class IntermediateNodeWrapper {
-public:
-    IntermediateNode* node;
-    uint64_t inDegree;
-    uint64_t outDegree;
-    bool isIn;
-
-    IntermediateNodeWrapper(IntermediateNode* node, bool isIn) {
-        this->node = node;
-        if (isIn) {
-            inDegree = node->incomingEdges.size();
-            outDegree = 0;
-            this->isIn = true;
-        } else {
-            outDegree = node->outgoingEdges.size();
-            inDegree = 0;
-            this->isIn = false;
-        }
+    TransitiveReducer reducer() const {
+        return TransitiveReducer(reductionOptions);
     }
 };
 
@@ -0,0 +1,386 @@
+//
+// microbenchmarks of the individual kernels of both transitive reduction algorithms, run on the bundled graphs
+// and on generated ones. Filter them with --benchmark_filter, e.g. --benchmark_filter='Query.*/graph_5'
+//
+
+#include "BitKernels.h"
+#include "GraphGenerator.h"
+#include "GraphParser.h"
+#include "IntermediateGraph.h"
+#include "TransitiveReducer.h"
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+/**
+ * a benchmark input, stored in both file formats
+ */
+struct GraphInput {
+    std::string name;
+    std::string textPath;
+    std::string binaryPath;
+};
+
+/**
+ * kinds of BFL queries, by what decides the query at its first node
+ */
+enum class QueryKind {
+    // the target lies in the DFS interval of the source
+    Positive,
+    // the labels rule out a path
+    Negative,
+    // neither cut applies, so the search expands the successors
+    Deep
+};
+
+class KernelBenchmarks {
+public:
+    /**
+     * the compressed graph of an input with a workspace reset for it and an engine with the default options
+     */
+    struct ReductionFixture {
+        ReductionGraph graph;
+        ReductionWorkspace workspace;
+        TransitiveReducer reducer;
+
+        explicit ReductionFixture(const GraphInput &input) : graph(loadGraph(input).view()) {
+            workspace.reset(graph);
+        }
+    };
+
+    static void importText(benchmark::State &state, const GraphInput &input) {
+        for (auto _: state) {
+            FinalGraph finalGraph = GraphParser::importFinalGraph(input.textPath);
+            benchmark::DoNotOptimize(finalGraph.edgeIds.data());
+        }
+        setEdgesProcessed(state, input);
+    }
+
+    static void importBinary(benchmark::State &state, const GraphInput &input) {
+        for (auto _: state) {
+            FinalGraph finalGraph = GraphParser::importFinalGraphBinary(input.binaryPath);
+            benchmark::DoNotOptimize(finalGraph.edgeIds.data());
+        }
+        setEdgesProcessed(state, input);
+    }
+
+    static void parseToIntermediateGraph(benchmark::State &state, const GraphInput &input) {
+        const FinalGraph &finalGraph = loadGraph(input);
+        for (auto _: state) {
+            state.PauseTiming();
+            FinalGraph copy = finalGraph;
+            state.ResumeTiming();
+            std::unique_ptr<IntermediateGraph> intermediateGraph =
+                    GraphParser::parseToIntermediateGraph(std::move(copy));
+            state.PauseTiming();
+            intermediateGraph.reset();
+            state.ResumeTiming();
+        }
+        setEdgesProcessed(state, input);
+    }
+
+    static void buildReductionGraph(benchmark::State &state, const GraphInput &input) {
+        const FinalGraph &finalGraph = loadGraph(input);
+        for (auto _: state) {
+            ReductionGraph graph(finalGraph.view());
+            benchmark::DoNotOptimize(graph.numberOfEdges());
+        }
+        setEdgesProcessed(state, input);
+    }
+
+    static void topoSort(benchmark::State &state, const GraphInput &input) {
+        ReductionFixture fixture(input);
+        for (auto _: state) {
+            fixture.reducer.topoSort(fixture.graph, fixture.workspace);
+        }
+        setEdgesProcessed(state, input);
+    }
+
+    static void postOrderTraverse(benchmark::State &state, const GraphInput &input) {
+        ReductionFixture fixture(input);
+        TransitiveReducer::prepareQueryStates(fixture.workspace, 1);
+        for (auto _: state) {
+            fixture.reducer.postOrderTraverse(fixture.graph, fixture.workspace);
+        }
+        setEdgesProcessed(state, input);
+    }
+
+    /**
+     * compute the in- or out-labels of all nodes in post-order, on a graph whose BFL intervals and groups are built
+     */
+    static void computeLabels(benchmark::State &state, const GraphInput &input, bool isOut) {
+        ReductionFixture fixture(input);
+        fixture.reducer.constructBFLRI(fixture.graph, fixture.workspace);
+        for (auto _: state) {
+            if (isOut) {
+                fixture.reducer.computeLabelOut(fixture.graph, fixture.workspace);
+            } else {
+                fixture.reducer.computeLabelIn(fixture.graph, fixture.workspace);
+            }
+        }
+        setEdgesProcessed(state, input);
+    }
+
+    /**
+     * one label containment check per iteration, cycling through the out-labels of the endpoints of all edges
+     */
+    static void isSubset(benchmark::State &state, const GraphInput &input) {
+        ReductionFixture fixture(input);
+        fixture.reducer.constructBFLRI(fixture.graph, fixture.workspace);
+        const ReductionGraph &graph = fixture.graph;
+        const ReductionWorkspace &workspace = fixture.workspace;
+        if (graph.numberOfEdges() == 0) {
+            state.SkipWithError("graph has no edges");
+            return;
+        }
+        std::uint64_t words = workspace.labelWords;
+        std::uint64_t i = 0;
+        for (auto _: state) {
+            benchmark::DoNotOptimize(TransitiveReducer::isSubset(workspace.labelOut.data() + graph.edgeEnd(i) * words,
+                                                                 workspace.labelOut.data() + graph.edgeStart(i) * words,
+                                                                 words));
+            i = i + 1 == graph.numberOfEdges() ? 0 : i + 1;
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+
+    /**
+     * one bit vector kernel call per iteration on vectors of state.range(0) words, with the kernels of the given
+     * level. The second vector has all bits set, so that subset checks run to the end.
+     */
+    template<typename Kernel>
+    static void bitKernel(benchmark::State &state, BitKernelLevel level, const Kernel &kernel) {
+        BitKernels::setLevel(level);
+        std::uint64_t words = static_cast<std::uint64_t>(state.range(0));
+        std::vector<std::uint64_t> a(words), b(words, ~std::uint64_t(0));
+        std::mt19937_64 generator(1);
+        for (std::uint64_t &word: a) {
+            word = generator() & generator();
+        }
+        for (auto _: state) {
+            benchmark::DoNotOptimize(kernel(a.data(), b.data(), words));
+            benchmark::ClobberMemory();
+        }
+        state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * words * sizeof(std::uint64_t)));
+        BitKernels::setLevel(BitKernels::bestLevel());
+    }
+
+    /**
+     * one BFL query of the given kind per iteration, cycling through sampled queries
+     */
+    static void query(benchmark::State &state, const GraphInput &input, QueryKind kind) {
+        ReductionFixture fixture(input);
+        fixture.reducer.constructBFLRI(fixture.graph, fixture.workspace);
+        std::vector<std::pair<std::uint64_t, std::uint64_t>> queries = sampleQueries(fixture, kind);
+        if (queries.empty()) {
+            state.SkipWithError("graph has no queries of this kind");
+            return;
+        }
+        QueryState &queryState = fixture.workspace.queryStates[0];
+        std::size_t i = 0;
+        for (auto _: state) {
+            benchmark::DoNotOptimize(TransitiveReducer::isReachable_BFL(fixture.graph, fixture.workspace, queryState,
+                                                                        queries[i].first, queries[i].second));
+            i = i + 1 == queries.size() ? 0 : i + 1;
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+
+    /**
+     * the edge ordering of TRO+, sorting copies of the adjacency lists in the workspace
+     */
+    static void sortEdgesTROPlus(benchmark::State &state, const GraphInput &input) {
+        ReductionFixture fixture(input);
+        fixture.reducer.topoSort(fixture.graph, fixture.workspace);
+        for (auto _: state) {
+            fixture.reducer.sortEdges_TROPlus(fixture.graph, fixture.workspace);
+            benchmark::DoNotOptimize(fixture.workspace.schedule.data());
+        }
+        setEdgesProcessed(state, input);
+    }
+
+    /**
+     * index construction and redundancy check of one algorithm, reusing one workspace for all iterations
+     */
+    static void reduce(benchmark::State &state, const GraphInput &input, ReductionAlgorithm algorithm) {
+        ReductionFixture fixture(input);
+        TransitiveReducer reducer(ReductionOptions::forAlgorithm(algorithm));
+        for (auto _: state) {
+            reducer.reduce(fixture.graph, fixture.workspace);
+        }
+        setEdgesProcessed(state, input);
+    }
+
+private:
+    static constexpr std::size_t maxQueriesPerKind = 4096;
+
+    /**
+     * the parsed graph of an input, imported once and shared by all benchmarks
+     */
+    static const FinalGraph &loadGraph(const GraphInput &input) {
+        static std::map<std::string, FinalGraph> graphs;
+        auto found = graphs.find(input.name);
+        if (found == graphs.end()) {
+            found = graphs.emplace(input.name, GraphParser::importFinalGraph(input.textPath)).first;
+        }
+        return found->second;
+    }
+
+    static void setEdgesProcessed(benchmark::State &state, const GraphInput &input) {
+        state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(loadGraph(input).numberOfEdges()));
+    }
+
+    /**
+     * collect queries of one kind from the two-hop paths u -> v -> w (reachable pairs u, w) and reversed
+     * edges v, u (unreachable pairs), classified by the checks of isReachable_BFL at the first node
+     */
+    static std::vector<std::pair<std::uint64_t, std::uint64_t>> sampleQueries(const ReductionFixture &fixture,
+                                                                              QueryKind kind) {
+        const ReductionGraph &graph = fixture.graph;
+        const ReductionWorkspace &workspace = fixture.workspace;
+        std::uint64_t words = workspace.labelWords;
+        auto labelOut = [&](std::uint64_t node) {
+            return workspace.labelOut.data() + node * words;
+        };
+        auto labelIn = [&](std::uint64_t node) {
+            return workspace.labelIn.data() + node * words;
+        };
+        std::vector<std::pair<std::uint64_t, std::uint64_t>> queries;
+        auto consider = [&](std::uint64_t a, std::uint64_t b) {
+            if (a == b || queries.size() >= maxQueriesPerKind) {
+                return;
+            }
+            QueryKind actual;
+            if (workspace.discoverTime[a] < workspace.discoverTime[b]
+                && workspace.finishTime[a] > workspace.finishTime[b]) {
+                actual = QueryKind::Positive;
+            } else if (!TransitiveReducer::isSubset(labelOut(b), labelOut(a), words)
+                       || !TransitiveReducer::isSubset(labelIn(a), labelIn(b), words)) {
+                actual = QueryKind::Negative;
+            } else {
+                actual = QueryKind::Deep;
+            }
+            if (actual == kind) {
+                queries.emplace_back(a, b);
+            }
+        };
+        for (std::uint64_t edge = 0; edge < graph.numberOfEdges(); ++edge) {
+            consider(graph.edgeEnd(edge), graph.edgeStart(edge));
+            for (std::uint64_t next: graph.outgoingEdges(graph.edgeEnd(edge))) {
+                consider(graph.edgeStart(edge), graph.edgeEnd(next));
+            }
+            if (queries.size() >= maxQueriesPerKind) {
+                break;
+            }
+        }
+        return queries;
+    }
+};
+
+/**
+ * the bundled graphs and one generated graph per model, with binary copies in the temporary directory
+ */
+static std::vector<GraphInput> collectInputs() {
+    std::filesystem::path workDirectory = std::filesystem::temp_directory_path() / "algorithm_project_benchmarks";
+    std::filesystem::create_directories(workDirectory);
+    std::vector<GraphInput> inputs;
+    std::filesystem::path graphDirectory = ALGORITHMPROJECT_GRAPH_DIRECTORY;
+    if (std::filesystem::is_directory(graphDirectory)) {
+        for (const auto &entry: std::filesystem::directory_iterator(graphDirectory)) {
+            if (entry.path().extension() == ".txt") {
+                inputs.push_back({entry.path().stem().string(), entry.path().string(), ""});
+            }
+        }
+    }
+    std::sort(inputs.begin(), inputs.end(), [](const GraphInput &a, const GraphInput &b) {
+        return a.name.size() != b.name.size() ? a.name.size() < b.name.size() : a.name < b.name;
+    });
+    for (const char* model: {"er", "layered", "powerlaw", "chain", "closure"}) {
+        GeneratorConfig config;
+        config.model = GraphGenerator::parseModel(model);
+        config.numberOfNodes = 5000;
+        config.numberOfEdges = 25000;
+        std::string name = std::string("generated_") + model;
+        std::string textPath = (workDirectory / (name + ".txt")).string();
+        GraphGenerator::generateToFile(config, textPath, GraphFileFormat::Text);
+        inputs.push_back({name, textPath, ""});
+    }
+    for (GraphInput &input: inputs) {
+        input.binaryPath = (workDirectory / (input.name + ".bin")).string();
+        GraphParser::exportFinalGraphBinary(GraphParser::importFinalGraph(input.textPath), input.binaryPath);
+    }
+    return inputs;
+}
+
+int main(int argc, char** argv) {
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    for (BitKernelLevel level: BitKernels::supportedLevels()) {
+        auto add = [level](const std::string &kernel, auto function) {
+            std::string name = kernel + "/" + BitKernels::levelName(level);
+            benchmark::RegisterBenchmark(name.c_str(), [level, function](benchmark::State &state) {
+                KernelBenchmarks::bitKernel(state, level, function);
+            })->Arg(16)->Arg(256);
+        };
+        add("BitOrInto", [](std::uint64_t* a, const std::uint64_t* b, std::uint64_t words) {
+            BitKernels::orInto(a, b, words);
+            return a[0];
+        });
+        add("BitIsSubset", [](const std::uint64_t* a, const std::uint64_t* b, std::uint64_t words) {
+            return BitKernels::isSubset(a, b, words);
+        });
+        add("BitPopcount", [](const std::uint64_t* a, const std::uint64_t*, std::uint64_t words) {
+            return BitKernels::popcount(a, words);
+        });
+        add("BitXorPopcount", [](const std::uint64_t* a, const std::uint64_t* b, std::uint64_t words) {
+            return BitKernels::xorPopcount(a, b, words);
+        });
+    }
+    for (const GraphInput &input: collectInputs()) {
+        auto add = [&input](const std::string &kernel, auto function) {
+            std::string name = kernel + "/" + input.name;
+            benchmark::RegisterBenchmark(name.c_str(), [input, function](benchmark::State &state) {
+                function(state, input);
+            });
+        };
+        add("ImportText", KernelBenchmarks::importText);
+        add("ImportBinary", KernelBenchmarks::importBinary);
+        add("ParseToIntermediateGraph", KernelBenchmarks::parseToIntermediateGraph);
+        add("BuildReductionGraph", KernelBenchmarks::buildReductionGraph);
+        add("TopoSort", KernelBenchmarks::topoSort);
+        add("PostOrderTraverse", KernelBenchmarks::postOrderTraverse);
+        add("ComputeLabelOut", [](benchmark::State &state, const GraphInput &input) {
+            KernelBenchmarks::computeLabels(state, input, true);
+        });
+        add("ComputeLabelIn", [](benchmark::State &state, const GraphInput &input) {
+            KernelBenchmarks::computeLabels(state, input, false);
+        });
+        add("IsSubset", KernelBenchmarks::isSubset);
+        add("QueryPositive", [](benchmark::State &state, const GraphInput &input) {
+            KernelBenchmarks::query(state, input, QueryKind::Positive);
+        });
+        add("QueryNegative", [](benchmark::State &state, const GraphInput &input) {
+            KernelBenchmarks::query(state, input, QueryKind::Negative);
+        });
+        add("QueryDeep", [](benchmark::State &state, const GraphInput &input) {
+            KernelBenchmarks::query(state, input, QueryKind::Deep);
+        });
+        add("SortEdgesTROPlus", KernelBenchmarks::sortEdgesTROPlus);
+        add("ReduceDFS", [](benchmark::State &state, const GraphInput &input) {
+            KernelBenchmarks::reduce(state, input, ReductionAlgorithm::DFS);
+        });
+        add("ReduceTROPlus", [](benchmark::State &state, const GraphInput &input) {
+            KernelBenchmarks::reduce(state, input, ReductionAlgorithm::TROPlus);
+        });
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,50 @@
+/**
+ * @file Parallel.h
+ * @brief This file contains runParallel, the loop over independent tasks shared by the parallel parts of the
+ * generator and the reduction engine.
+ */
+#ifndef ALGORITHMPROJECT_PARALLEL_H
+#define ALGORITHMPROJECT_PARALLEL_H
+
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief the number of threads to use for numberOfThreads, where 0 means all hardware threads
+ */
+inline unsigned resolveThreadCount(unsigned numberOfThreads) {
+    return numberOfThreads > 0 ? numberOfThreads : std::max(1u, std::thread::hardware_concurrency());
+}
+
+/**
+ * @brief run task(i, worker) for i in [0, count) on the given number of threads, 0 for all hardware threads.
+ * Tasks are handed out dynamically. worker is the index of the running thread in [0, numberOfThreads), so that
+ * tasks can use per-thread scratch space. The calling thread is worker 0. Task is a template parameter rather
+ * than a std::function, so that a run allocates nothing on one thread.
+ */
+template<typename Task>
+void runParallel(std::uint64_t count, unsigned numberOfThreads, const Task &task) {
+    numberOfThreads = static_cast<unsigned>(std::min<std::uint64_t>(resolveThreadCount(numberOfThreads),
+                                                                    std::max<std::uint64_t>(count, 1)));
+    std::atomic<std::uint64_t> next{0};
+    auto worker = [&](unsigned workerIndex) {
+        for (std::uint64_t i = next++; i < count; i = next++) {
+            task(i, workerIndex);
+        }
+    };
+    std::vector<std::thread> threads;
+    for (unsigned t = 1; t < numberOfThreads; ++t) {
+        threads.emplace_back(worker, t);
+    }
+    worker(0);
+    for (std::thread &thread: threads) {
+        thread.join();
+    }
+}
+
+
+#endif //ALGORITHMPROJECT_PARALLEL_H
@@ -0,0 +1,136 @@
+//
+// PerfCounterGroup reads hardware performance counters through perf_event_open
+//
+
+#include "PerfCounters.h"
+
+#ifdef __linux__
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+enum CounterKind {
+    Cycles,
+    Instructions,
+    CacheMisses,
+    BranchMisses,
+    DtlbMisses
+};
+
+/**
+ * open one counter of the calling thread on any CPU, disabled until the group leader is enabled
+ */
+static int openCounter(std::uint32_t type, std::uint64_t config, int groupLeader) {
+    perf_event_attr attributes{};
+    attributes.size = sizeof(attributes);
+    attributes.type = type;
+    attributes.config = config;
+    attributes.disabled = groupLeader < 0 ? 1 : 0;
+    attributes.exclude_kernel = 1;
+    attributes.exclude_hv = 1;
+    attributes.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return static_cast<int>(syscall(SYS_perf_event_open, &attributes, 0, -1, groupLeader, 0));
+}
+
+PerfCounterGroup::PerfCounterGroup() {
+    const struct {
+        std::uint32_t type;
+        std::uint64_t config;
+        int kind;
+    } events[maxCounters] = {
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES,    Cycles},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS,  Instructions},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES,  CacheMisses},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES, BranchMisses},
+            {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_DTLB
+                                 | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                                 | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16), DtlbMisses},
+    };
+    for (const auto &event: events) {
+        int descriptor = openCounter(event.type, event.config, leader);
+        if (descriptor < 0) {
+            continue;
+        }
+        if (leader < 0) {
+            leader = descriptor;
+        }
+        descriptors[numberOfCounters] = descriptor;
+        kinds[numberOfCounters] = event.kind;
+        numberOfCounters++;
+    }
+}
+
+PerfCounterGroup::~PerfCounterGroup() {
+    for (int i = 0; i < numberOfCounters; ++i) {
+        close(descriptors[i]);
+    }
+}
+
+void PerfCounterGroup::start() {
+    if (leader < 0) {
+        return;
+    }
+    ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+}
+
+HardwareCounterValues PerfCounterGroup::stop() {
+    HardwareCounterValues values;
+    if (leader < 0) {
+        return values;
+    }
+    ioctl(leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+    // layout of a group read: number of counters, time enabled, time running, one value per counter
+    std::uint64_t buffer[3 + maxCounters];
+    if (read(leader, buffer, sizeof(buffer)) < static_cast<ssize_t>(3 * sizeof(std::uint64_t))) {
+        return values;
+    }
+    double scale = buffer[2] > 0 ? static_cast<double>(buffer[1]) / static_cast<double>(buffer[2]) : 0;
+    for (std::uint64_t i = 0; i < buffer[0] && i < static_cast<std::uint64_t>(numberOfCounters); ++i) {
+        auto value = static_cast<std::uint64_t>(static_cast<double>(buffer[3 + i]) * scale);
+        switch (kinds[i]) {
+            case Cycles:
+                values.hasCycles = true;
+                values.cycles = value;
+                break;
+            case Instructions:
+                values.hasInstructions = true;
+                values.instructions = value;
+                break;
+            case CacheMisses:
+                values.hasCacheMisses = true;
+                values.cacheMisses = value;
+                break;
+            case BranchMisses:
+                values.hasBranchMisses = true;
+                values.branchMisses = value;
+                break;
+            case DtlbMisses:
+                values.hasDtlbMisses = true;
+                values.dtlbMisses = value;
+                break;
+        }
+    }
+    return values;
+}
+
+#else
+
+PerfCounterGroup::PerfCounterGroup() = default;
+
+PerfCounterGroup::~PerfCounterGroup() = default;
+
+void PerfCounterGroup::start() {}
+
+HardwareCounterValues PerfCounterGroup::stop() {
+    return {};
+}
+
+#endif
+
+PerfCounterGroup &PerfCounterGroup::forCurrentThread() {
+    thread_local PerfCounterGroup group;
+    return group;
+}
@@ -0,0 +1,83 @@
+/**
+ * @file PerfCounters.h
+ * @brief This file contains PerfCounterGroup, a group of hardware performance counters (cycles, instructions,
+ * cache misses, branch misses, dTLB misses) of the calling thread, read through perf_event_open on Linux.
+ */
+#ifndef ALGORITHMPROJECT_PERFCOUNTERS_H
+#define ALGORITHMPROJECT_PERFCOUNTERS_H
+
+
+#include <cstdint>
+
+/**
+ * @brief counter values of one measured interval. A counter the CPU or kernel does not provide stays unavailable,
+ * e.g. all of them inside most containers and VMs.
+ */
+struct HardwareCounterValues {
+    bool hasCycles = false;
+    bool hasInstructions = false;
+    bool hasCacheMisses = false;
+    bool hasBranchMisses = false;
+    bool hasDtlbMisses = false;
+    std::uint64_t cycles = 0;
+    std::uint64_t instructions = 0;
+    std::uint64_t cacheMisses = 0;
+    std::uint64_t branchMisses = 0;
+    std::uint64_t dtlbMisses = 0;
+
+    /**
+     * @brief instructions per cycle, 0 if either counter is unavailable
+     */
+    double instructionsPerCycle() const {
+        return hasCycles && hasInstructions && cycles > 0
+               ? static_cast<double>(instructions) / static_cast<double>(cycles) : 0;
+    }
+};
+
+class PerfCounterGroup {
+public:
+    /**
+     * @brief open the counters for the calling thread, user space only. Counters that cannot be opened are skipped.
+     */
+    PerfCounterGroup();
+
+    PerfCounterGroup(const PerfCounterGroup &) = delete;
+
+    PerfCounterGroup &operator=(const PerfCounterGroup &) = delete;
+
+    ~PerfCounterGroup();
+
+    /**
+     * @brief whether at least one counter could be opened
+     */
+    bool isAvailable() const {
+        return leader >= 0;
+    }
+
+    /**
+     * @brief reset and enable all counters of the group
+     */
+    void start();
+
+    /**
+     * @brief disable the counters and read them, scaled up if the kernel multiplexed the group
+     */
+    HardwareCounterValues stop();
+
+    /**
+     * @brief the counter group of the calling thread, opened on first use. Counters are per thread, so every
+     * thread measuring a phase uses its own group.
+     */
+    static PerfCounterGroup &forCurrentThread();
+
+private:
+    static constexpr int maxCounters = 5;
+    int leader = -1;
+    // file descriptor and HardwareCounterValues field index of every opened counter, in group read order
+    int descriptors[maxCounters];
+    int kinds[maxCounters];
+    int numberOfCounters = 0;
+};
+
+
+#endif //ALGORITHMPROJECT_PERFCOUNTERS_H
@@ -0,0 +1,232 @@
+//
+// PhaseProfiler measures the phases of a transitive reduction run
+//
+
+#include "PhaseProfiler.h"
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+#include <string>
+#include <ctime>
+#include <sys/resource.h>
+
+#ifdef ALGORITHMPROJECT_COUNT_ALLOCATIONS
+static std::atomic<std::uint64_t> numberOfAllocations{0};
+static std::atomic<std::uint64_t> numberOfAllocatedBytes{0};
+
+/**
+ * count an allocation and forward it to malloc
+ */
+static void* countedAllocate(std::size_t size) {
+    numberOfAllocations.fetch_add(1, std::memory_order_relaxed);
+    numberOfAllocatedBytes.fetch_add(size, std::memory_order_relaxed);
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+static void* countedAllocateAligned(std::size_t size, std::align_val_t alignment) {
+    numberOfAllocations.fetch_add(1, std::memory_order_relaxed);
+    numberOfAllocatedBytes.fetch_add(size, std::memory_order_relaxed);
+    auto align = static_cast<std::size_t>(alignment);
+    // aligned_alloc requires the size to be a multiple of the alignment
+    return std::aligned_alloc(align, (size + align - 1) / align * align);
+}
+
+void* operator new(std::size_t size) {
+    void* pointer = countedAllocate(size);
+    if (pointer == nullptr) {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t &) noexcept {
+    return countedAllocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t &) noexcept {
+    return countedAllocate(size);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    void* pointer = countedAllocateAligned(size, alignment);
+    if (pointer == nullptr) {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+    return operator new(size, alignment);
+}
+
+void operator delete(void* pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept {
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::align_val_t) noexcept {
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer, std::align_val_t) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t, std::align_val_t) noexcept {
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t, std::align_val_t) noexcept {
+    std::free(pointer);
+}
+#endif
+
+bool PhaseProfiler::countsAllocations() {
+#ifdef ALGORITHMPROJECT_COUNT_ALLOCATIONS
+    return true;
+#else
+    return false;
+#endif
+}
+
+std::uint64_t PhaseProfiler::allocationCount() {
+#ifdef ALGORITHMPROJECT_COUNT_ALLOCATIONS
+    return numberOfAllocations.load(std::memory_order_relaxed);
+#else
+    return 0;
+#endif
+}
+
+std::uint64_t PhaseProfiler::allocatedBytes() {
+#ifdef ALGORITHMPROJECT_COUNT_ALLOCATIONS
+    return numberOfAllocatedBytes.load(std::memory_order_relaxed);
+#else
+    return 0;
+#endif
+}
+
+double PhaseProfiler::processCpuMicroseconds() {
+    timespec time{};
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &time);
+    return static_cast<double>(time.tv_sec) * 1e6 + static_cast<double>(time.tv_nsec) / 1e3;
+}
+
+/**
+ * read a "<key>: <value> kB" line of /proc/self/status, -1 if it is not available
+ */
+static std::int64_t readProcStatus(const std::string &key) {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.compare(0, key.size(), key) == 0 && line.size() > key.size() && line[key.size()] == ':') {
+            return std::stoll(line.substr(key.size() + 1));
+        }
+    }
+    return -1;
+}
+
+static std::int64_t maxRssFromRusage() {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024;
+#else
+    return usage.ru_maxrss;
+#endif
+}
+
+std::int64_t PhaseProfiler::resetPeakRss() {
+    // writing 5 to clear_refs resets VmHWM to the current RSS (Linux 4.0+)
+    std::ofstream clearRefs("/proc/self/clear_refs");
+    if (clearRefs && (clearRefs << "5").flush()) {
+        std::int64_t rss = readProcStatus("VmRSS");
+        if (rss >= 0) {
+            return rss;
+        }
+    }
+    return peakRss();
+}
+
+std::int64_t PhaseProfiler::currentRss() {
+    std::int64_t rss = readProcStatus("VmRSS");
+    return rss >= 0 ? rss : peakRss();
+}
+
+std::int64_t PhaseProfiler::peakRss() {
+    std::int64_t highWaterMark = readProcStatus("VmHWM");
+    return highWaterMark >= 0 ? highWaterMark : maxRssFromRusage();
+}
+
+const char* PhaseProfiler::phaseName(Phase phase) {
+    switch (phase) {
+        case Phase::Import:
+            return "import";
+        case Phase::IntermediateBuild:
+            return "intermediate_build";
+        case Phase::Reorder:
+            return "reorder";
+        case Phase::IndexBuild:
+            return "index_build";
+        case Phase::TopoSort:
+            return "topo_sort";
+        case Phase::EdgeSort:
+            return "edge_sort";
+        case Phase::RedundancyCheck:
+            return "redundancy_check";
+        case Phase::Export:
+            return "export";
+    }
+    return "unknown";
+}
+
+PhaseProfiler::Scope::Scope(PhaseProfiler* profiler, Phase phase, std::string label)
+        : profiler(profiler), measurement{phase, std::move(label)} {
+    if (profiler == nullptr) {
+        return;
+    }
+    if (profiler->trackMemory) {
+        rssStart = resetPeakRss();
+    }
+    allocationsStart = allocationCount();
+    allocatedBytesStart = allocatedBytes();
+    cpuStart = processCpuMicroseconds();
+    wallStart = std::chrono::steady_clock::now();
+    if (profiler->countHardwareEvents) {
+        counterGroup = &PerfCounterGroup::forCurrentThread();
+        counterGroup->start();
+    }
+}
+
+PhaseProfiler::Scope::~Scope() {
+    if (profiler == nullptr) {
+        return;
+    }
+    if (counterGroup != nullptr) {
+        measurement.counters = counterGroup->stop();
+    }
+    auto wallStop = std::chrono::steady_clock::now();
+    measurement.cpuMicroseconds = processCpuMicroseconds() - cpuStart;
+    measurement.wallMicroseconds = std::chrono::duration<double, std::micro>(wallStop - wallStart).count();
+    measurement.allocations = allocationCount() - allocationsStart;
+    measurement.allocatedBytes = allocatedBytes() - allocatedBytesStart;
+    if (profiler->trackMemory) {
+        measurement.peakRssDeltaKilobytes = peakRss() - rssStart;
+    }
+    profiler->measurements.push_back(std::move(measurement));
+}
@@ -0,0 +1,137 @@
+/**
+ * @file PhaseProfiler.h
+ * @brief This file contains PhaseProfiler, which records wall time, CPU time, peak RSS growth and heap allocations
+ * of the phases of a transitive reduction run (import, graph build, index build, sorting, redundancy check, export),
+ * and optionally the hardware performance counters of the measuring thread.
+ */
+#ifndef ALGORITHMPROJECT_PHASEPROFILER_H
+#define ALGORITHMPROJECT_PHASEPROFILER_H
+
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "PerfCounters.h"
+
+/**
+ * @brief the phases of importing, reducing and exporting a graph
+ */
+enum class Phase {
+    Import,
+    IntermediateBuild,
+    // renumbering nodes and edges for locality, only with a NodeOrdering other than the input order
+    Reorder,
+    IndexBuild,
+    TopoSort,
+    EdgeSort,
+    RedundancyCheck,
+    Export
+};
+
+/**
+ * @brief resources used by one execution of a phase
+ */
+struct PhaseMeasurement {
+    Phase phase;
+    // the algorithm or index the phase belongs to, e.g. "DFS" or "TRO+", empty for shared phases
+    std::string label;
+    double wallMicroseconds = 0;
+    // CPU time of all threads of the process
+    double cpuMicroseconds = 0;
+    // growth of the peak resident set during the phase
+    std::int64_t peakRssDeltaKilobytes = 0;
+    std::uint64_t allocations = 0;
+    std::uint64_t allocatedBytes = 0;
+    // hardware counters of the thread that ran the phase, only set if the profiler counts hardware events
+    HardwareCounterValues counters{};
+};
+
+class PhaseProfiler {
+public:
+    /**
+     * @brief measures the enclosing block as one execution of a phase. A scope with a null profiler does nothing,
+     * so instrumented code can take an optional profiler.
+     */
+    class Scope {
+    public:
+        Scope(PhaseProfiler* profiler, Phase phase, std::string label = "");
+
+        Scope(const Scope &) = delete;
+
+        Scope &operator=(const Scope &) = delete;
+
+        ~Scope();
+
+    private:
+        PhaseProfiler* profiler;
+        PhaseMeasurement measurement;
+        std::chrono::steady_clock::time_point wallStart;
+        double cpuStart = 0;
+        std::int64_t rssStart = 0;
+        std::uint64_t allocationsStart = 0;
+        std::uint64_t allocatedBytesStart = 0;
+        PerfCounterGroup* counterGroup = nullptr;
+    };
+
+    /**
+     * @param trackMemory measure peak RSS growth. Resetting and reading the peak costs a few system calls per phase.
+     * @param countHardwareEvents read the perf counter group of the thread entering a scope. Phases stay
+     * unmeasured where the counters are not available, e.g. in containers without perf_event access.
+     */
+    explicit PhaseProfiler(bool trackMemory = true, bool countHardwareEvents = false)
+            : trackMemory(trackMemory), countHardwareEvents(countHardwareEvents) {}
+
+    const std::vector<PhaseMeasurement> &getMeasurements() const {
+        return measurements;
+    }
+
+    void clear() {
+        measurements.clear();
+    }
+
+    static const char* phaseName(Phase phase);
+
+    /**
+     * @brief whether the build counts heap allocations, see the ALGORITHMPROJECT_COUNT_ALLOCATIONS option
+     */
+    static bool countsAllocations();
+
+    /**
+     * @brief number of heap allocations of the process so far, 0 if allocation counting is compiled out
+     */
+    static std::uint64_t allocationCount();
+
+    /**
+     * @brief number of bytes requested from the heap so far, 0 if allocation counting is compiled out
+     */
+    static std::uint64_t allocatedBytes();
+
+    /**
+     * @brief CPU time of the process so far
+     */
+    static double processCpuMicroseconds();
+
+    /**
+     * @brief current RSS of the process in kB, or the peak RSS where the current one cannot be read
+     */
+    static std::int64_t currentRss();
+
+private:
+    bool trackMemory;
+    bool countHardwareEvents;
+    std::vector<PhaseMeasurement> measurements;
+
+    /**
+     * @brief reset the peak RSS to the current RSS where the OS allows it, and return the current RSS in kB
+     */
+    static std::int64_t resetPeakRss();
+
+    /**
+     * @brief peak RSS in kB since the last reset, or since process start if resetting is not supported
+     */
+    static std::int64_t peakRss();
+};
+
+
+#endif //ALGORITHMPROJECT_PHASEPROFILER_H
@@ -0,0 +1,17 @@
+//
+// libFuzzer entry point: every input is decoded into a small DAG and checked with all reduction engines
+//
+
+#include "DifferentialTester.h"
+#include <cstdlib>
+#include <iostream>
+
+
+extern "C" int LLVMFuzzerTestOneInput(const std::uint8_t* data, std::size_t size) {
+    std::string failure = DifferentialTester::checkGraph(DifferentialTester::decodeGraph(data, size));
+    if (!failure.empty()) {
+        std::cerr << failure << "\n";
+        std::abort();
+    }
+    return 0;
+}
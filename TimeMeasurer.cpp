@@ -2,68 +2,383 @@
 #include "TimeMeasurer.h"
 #include "GraphParser.h"
 #include <iostream>
-#include "IntermediateGraph.h"
+#include "PhaseProfiler.h"
+#include "TransitiveReducer.h"
+#include <algorithm>
 #include <chrono>
+#include <cmath>
 #include <numeric>
+#include <optional>
 #include <string>
+#include <utility>
 #include <fstream>
+#ifdef __linux__
+#include <sched.h>
+#endif
 
-void TimeMeasurer::measureGraphTRTime(std::string performanceFilePath, std::string graphFilePath) {
-    std::vector<uint64_t> time_DFSRI;
-    std::vector<uint64_t> time_DFS;
-    std::vector<uint64_t> time_BFL;
-    std::vector<uint64_t> time_TRO;
-
-    for (int i = 0; i < 10; ++i) {
-        FinalGraph* graph = GraphParser::importFinalGraph(graphFilePath);
-        IntermediateGraph* intermediateGraph = GraphParser::parseToIntermediateGraph(graph);
-        auto start1 = std::chrono::high_resolution_clock::now();
-        intermediateGraph->constructDFSRI();
-        auto start1part1 = std::chrono::high_resolution_clock::now();
-        intermediateGraph->markRedundantEdges_DFS();
-        auto start2 = std::chrono::high_resolution_clock::now();
-        intermediateGraph->constructBFLRI();
-        auto start2part1 = std::chrono::high_resolution_clock::now();
-        intermediateGraph->markRedundantEdges_TROPlus(false);
-        auto stop = std::chrono::high_resolution_clock::now();
-
-        time_DFSRI.push_back(duration_cast<std::chrono::microseconds>(start1part1 - start1).count());
-        time_DFS.push_back(duration_cast<std::chrono::microseconds>(start2 - start1).count());
-        time_BFL.push_back(duration_cast<std::chrono::microseconds>(start2part1 - start2).count());
-        time_TRO.push_back(duration_cast<std::chrono::microseconds>(stop - start2).count());
-        delete intermediateGraph;
-        delete graph;
-        std::cout << "GOT " << i << std::endl;
-    }
-    double dfs_ri = calculateMean(time_DFSRI);
-    double dfs = calculateMean(time_DFS);
-    double bfl = calculateMean(time_BFL);
-    double tro = calculateMean(time_TRO);
-
-    std::ofstream file("algorithm_performance_data.csv", std::ios::app);
-    file << graphFilePath << ","
-         << dfs_ri << ","
-         << dfs << ","
-         << bfl << ","
-         << tro << "\n";
+/**
+ * two-sided 95% Student t quantiles for 1 to 30 degrees of freedom
+ */
+static const double tQuantiles95[] = {12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+                                      2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+                                      2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
 
+/**
+ * read every node and edge once, so that their pages are resident before the timed section
+ */
+static void prefaultGraph(const ReductionGraph &graph) {
+    volatile std::uint64_t sum = 0;
+    for (std::uint64_t node = 0; node < graph.numberOfNodes(); ++node) {
+        sum = sum + graph.nodeId(node) + graph.outDegree(node) + graph.inDegree(node);
+    }
+    for (std::uint64_t edge = 0; edge < graph.numberOfEdges(); ++edge) {
+        sum = sum + graph.edgeStart(edge) + graph.edgeEnd(edge);
+    }
+}
+
+/**
+ * append the available hardware counters of a phase. The counter group of a thread is opened once, so the same
+ * counters are available in every phase run.
+ */
+static void appendCounterValues(const HardwareCounterValues &counters,
+                                std::vector<std::pair<const char*, double>> &values) {
+    if (counters.hasCycles) {
+        values.emplace_back("cycles", static_cast<double>(counters.cycles));
+    }
+    if (counters.hasInstructions) {
+        values.emplace_back("instructions", static_cast<double>(counters.instructions));
+    }
+    if (counters.hasCycles && counters.hasInstructions) {
+        values.emplace_back("ipc", counters.instructionsPerCycle());
+    }
+    if (counters.hasCacheMisses) {
+        values.emplace_back("cache_misses", static_cast<double>(counters.cacheMisses));
+    }
+    if (counters.hasBranchMisses) {
+        values.emplace_back("branch_misses", static_cast<double>(counters.branchMisses));
+    }
+    if (counters.hasDtlbMisses) {
+        values.emplace_back("dtlb_misses", static_cast<double>(counters.dtlbMisses));
+    }
+}
+
+/**
+ * append the index sizes of a graph, and its query counters if the library counts queries
+ */
+static void appendQueryStatistics(const QueryStatistics &statistics,
+                                  std::vector<std::pair<std::string, double>> &values) {
+    values.emplace_back("DFS_RI/index/pairs", static_cast<double>(statistics.dfsRiPairs));
+    values.emplace_back("DFS_RI/index/bytes", static_cast<double>(statistics.dfsRiIndexBytes));
+    values.emplace_back("BFL/index/label_entries", static_cast<double>(statistics.bflLabelEntries));
+    values.emplace_back("BFL/index/bytes", static_cast<double>(statistics.bflIndexBytes));
+    if (!TransitiveReducer::isCountingQueries()) {
+        return;
+    }
+    values.emplace_back("DFS_RI/query/queries", static_cast<double>(statistics.dfsRiQueries));
+    values.emplace_back("DFS_RI/query/hits", static_cast<double>(statistics.dfsRiHits));
+    values.emplace_back("DFS_RI/query/probes", static_cast<double>(statistics.dfsRiProbes));
+    values.emplace_back("BFL/query/queries", static_cast<double>(statistics.bflQueries));
+    values.emplace_back("BFL/query/identity_hits", static_cast<double>(statistics.bflIdentityHits));
+    values.emplace_back("BFL/query/interval_hits", static_cast<double>(statistics.bflIntervalHits));
+    values.emplace_back("BFL/query/label_cuts", static_cast<double>(statistics.bflLabelCuts));
+    values.emplace_back("BFL/query/expanded_nodes", static_cast<double>(statistics.bflExpandedNodes));
+    values.emplace_back("BFL/query/max_depth", static_cast<double>(statistics.bflMaxDepth));
+}
+
+/**
+ * the compressed graph of a file, with its nodes renumbered in the given order
+ */
+static ReductionGraph loadGraph(const std::string &graphFilePath, NodeOrdering ordering) {
+    FinalGraph finalGraph = GraphParser::importFinalGraph(graphFilePath,
+                                                          GraphParser::detectGraphFileFormat(graphFilePath));
+    if (ordering == NodeOrdering::Input) {
+        return ReductionGraph(finalGraph.view());
+    }
+    return ReductionGraph(GraphReorderer::reorder(finalGraph, ordering).graph.view());
+}
+
+std::vector<MeasurementSummary> TimeMeasurer::measureGraphTRTime(const std::string &graphFilePath,
+                                                                 const BenchmarkConfig &config) {
+    if (config.prefaultInputs) {
+        prefaultFile(graphFilePath);
+    }
+    const std::vector<std::string> metrics = {"DFS_RI", "DFS", "BFL", "TRO"};
+    // the graph is parsed and reordered once, every iteration only resets the workspace, which keeps its arrays
+    ReductionGraph graph = loadGraph(graphFilePath, config.ordering);
+    ReductionWorkspace workspace;
+    TransitiveReducer reducer;
+    if (config.prefaultInputs) {
+        prefaultGraph(graph);
+    }
+    auto sample = [&]() {
+        workspace.reset(graph);
+        auto start1 = std::chrono::steady_clock::now();
+        reducer.constructDFSRI(graph, workspace);
+        auto start1part1 = std::chrono::steady_clock::now();
+        reducer.markRedundantEdges_DFS(graph, workspace, ReachabilityIndex::DFS_RI);
+        auto start2 = std::chrono::steady_clock::now();
+        reducer.constructBFLRI(graph, workspace);
+        auto start2part1 = std::chrono::steady_clock::now();
+        reducer.markRedundantEdges_TROPlus(graph, workspace, ReachabilityIndex::BFL);
+        auto stop = std::chrono::steady_clock::now();
+
+        using Microseconds = std::chrono::duration<double, std::micro>;
+        return std::vector<double>{Microseconds(start1part1 - start1).count(),
+                                   Microseconds(start2 - start1part1).count(),
+                                   Microseconds(start2part1 - start2).count(),
+                                   Microseconds(stop - start2part1).count()};
+    };
+
+    std::vector<std::vector<double>> samples = repeatUntilStable(config, metrics.size(), sample);
+    std::vector<MeasurementSummary> summaries;
+    for (std::size_t i = 0; i < metrics.size(); ++i) {
+        summaries.push_back(summarize(graphFilePath, metrics[i], std::move(samples[i])));
+    }
+    std::vector<MeasurementSummary> phaseSummaries = measureGraphPhases(graphFilePath, config);
+    summaries.insert(summaries.end(), phaseSummaries.begin(), phaseSummaries.end());
+    return summaries;
+}
+
+std::vector<MeasurementSummary> TimeMeasurer::measureGraphPhases(const std::string &graphFilePath,
+                                                                 const BenchmarkConfig &config) {
+    // samples of every "<label>/<phase>/<resource>", in the order of the first run
+    std::vector<std::string> names;
+    std::vector<std::vector<double>> samples;
+    // shared by all runs like in a long running caller, so allocations in the algorithm phases are the ones
+    // of a warm workspace after the first run
+    ReductionWorkspace workspace;
+    TransitiveReducer reducer;
+    for (unsigned run = 0; run < config.phaseRuns; ++run) {
+        PhaseProfiler profiler(config.trackPhaseMemory, config.countHardwareEvents);
+        FinalGraph finalGraph;
+        {
+            PhaseProfiler::Scope scope(&profiler, Phase::Import);
+            finalGraph = GraphParser::importFinalGraph(graphFilePath,
+                                                       GraphParser::detectGraphFileFormat(graphFilePath));
+        }
+        std::optional<ReorderedGraph> reordered;
+        if (config.ordering != NodeOrdering::Input) {
+            PhaseProfiler::Scope scope(&profiler, Phase::Reorder);
+            reordered = GraphReorderer::reorder(finalGraph, config.ordering);
+        }
+        std::optional<ReductionGraph> graph;
+        {
+            PhaseProfiler::Scope scope(&profiler, Phase::IntermediateBuild);
+            graph.emplace(reordered ? reordered->graph.view() : finalGraph.view());
+        }
+        workspace.reset(*graph);
+        workspace.profiler = &profiler;
+        reducer.constructDFSRI(*graph, workspace);
+        reducer.markRedundantEdges_DFS(*graph, workspace, ReachabilityIndex::DFS_RI);
+        reducer.constructBFLRI(*graph, workspace);
+        reducer.markRedundantEdges_TROPlus(*graph, workspace, ReachabilityIndex::BFL);
+        workspace.profiler = nullptr;
+        if (!config.exportFilePath.empty()) {
+            PhaseProfiler::Scope scope(&profiler, Phase::Export, "TRO+");
+            if (reordered) {
+                // back to the edge order of the file
+                workspace.isRedundant = reordered->toInputOrder(workspace.isRedundant);
+            }
+            GraphParser::exportReducedGraph(finalGraph.view(), workspace.redundancyBitmap(), config.exportFilePath,
+                                            GraphFileFormat::Text);
+        }
+        QueryStatistics statistics = TransitiveReducer::getQueryStatistics(workspace);
+
+        std::vector<std::pair<std::string, double>> runValues;
+        for (const PhaseMeasurement &measurement: profiler.getMeasurements()) {
+            std::string name = measurement.label.empty()
+                               ? PhaseProfiler::phaseName(measurement.phase)
+                               : measurement.label + "/" + PhaseProfiler::phaseName(measurement.phase);
+            std::vector<std::pair<const char*, double>> values = {
+                    {"wall_us",           measurement.wallMicroseconds},
+                    {"cpu_us",            measurement.cpuMicroseconds},
+                    {"peak_rss_delta_kb", static_cast<double>(measurement.peakRssDeltaKilobytes)}};
+            // allocation counts are left out of builds without the counting operator new, not reported as 0
+            if (PhaseProfiler::countsAllocations()) {
+                values.emplace_back("allocations", static_cast<double>(measurement.allocations));
+                values.emplace_back("allocated_bytes", static_cast<double>(measurement.allocatedBytes));
+            }
+            appendCounterValues(measurement.counters, values);
+            for (const auto &[resource, value]: values) {
+                runValues.emplace_back(name + "/" + resource, value);
+            }
+        }
+        appendQueryStatistics(statistics, runValues);
+        for (std::size_t i = 0; i < runValues.size(); ++i) {
+            if (run == 0) {
+                names.push_back(runValues[i].first);
+                samples.emplace_back();
+            }
+            samples[i].push_back(runValues[i].second);
+        }
+    }
+    std::vector<MeasurementSummary> summaries;
+    for (std::size_t i = 0; i < names.size(); ++i) {
+        summaries.push_back(summarize(graphFilePath, names[i], std::move(samples[i])));
+    }
+    return summaries;
+}
+
+std::vector<MeasurementSummary> TimeMeasurer::startMeasurement(const std::vector<std::string> &filePaths,
+                                                               const BenchmarkConfig &config) {
+    if (config.cpu >= 0 && !pinToCpu(config.cpu)) {
+        std::cerr << "Could not pin benchmark to CPU " << config.cpu << ", running unpinned" << std::endl;
+    }
+    std::vector<MeasurementSummary> summaries;
+    for (const std::string &filePath: filePaths) {
+        std::vector<MeasurementSummary> graphSummaries = measureGraphTRTime(filePath, config);
+        summaries.insert(summaries.end(), graphSummaries.begin(), graphSummaries.end());
+    }
+    if (!config.csvFilePath.empty()) {
+        writeCsv(config.csvFilePath, summaries);
+    }
+    if (!config.jsonFilePath.empty()) {
+        writeJson(config.jsonFilePath, summaries);
+    }
+    return summaries;
+}
+
+std::vector<std::vector<double>> TimeMeasurer::repeatUntilStable(const BenchmarkConfig &config,
+                                                                 std::size_t numberOfMetrics,
+                                                                 const std::function<std::vector<double>()> &sample) {
+    for (unsigned i = 0; i < config.warmupRuns; ++i) {
+        sample();
+    }
+    std::vector<std::vector<double>> samples(numberOfMetrics);
+    auto start = std::chrono::steady_clock::now();
+    while (samples[0].size() < std::max(config.maxRuns, 1u)) {
+        std::vector<double> durations = sample();
+        for (std::size_t i = 0; i < numberOfMetrics; ++i) {
+            samples[i].push_back(durations[i]);
+        }
+        if (samples[0].size() < std::max(config.minRuns, 2u)) {
+            continue;
+        }
+        bool isStable = std::all_of(samples.begin(), samples.end(), [&config](const std::vector<double> &data) {
+            MeasurementSummary summary = summarize("", "", data);
+            return summary.confidenceHalfWidth <= config.targetRelativeConfidence * summary.mean;
+        });
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        if (isStable || elapsed.count() > config.maxSecondsPerGraph) {
+            break;
+        }
+    }
+    return samples;
+}
+
+MeasurementSummary TimeMeasurer::summarize(const std::string &graphName, const std::string &metric,
+                                           std::vector<double> samples) {
+    MeasurementSummary summary;
+    summary.graphName = graphName;
+    summary.metric = metric;
+    summary.runs = samples.size();
+    if (samples.empty()) {
+        return summary;
+    }
+    std::sort(samples.begin(), samples.end());
+    auto percentile = [&samples](double p) {
+        double rank = p * static_cast<double>(samples.size() - 1);
+        auto lower = static_cast<std::size_t>(rank);
+        std::size_t upper = std::min(lower + 1, samples.size() - 1);
+        return samples[lower] + (samples[upper] - samples[lower]) * (rank - static_cast<double>(lower));
+    };
+    summary.mean = calculateMean(samples);
+    summary.median = percentile(0.5);
+    summary.p90 = percentile(0.9);
+    summary.p99 = percentile(0.99);
+    summary.min = samples.front();
+    summary.max = samples.back();
+    if (samples.size() > 1) {
+        double squares = 0;
+        for (double value: samples) {
+            squares += (value - summary.mean) * (value - summary.mean);
+        }
+        summary.stddev = std::sqrt(squares / static_cast<double>(samples.size() - 1));
+        std::size_t degreesOfFreedom = samples.size() - 1;
+        double t = degreesOfFreedom <= std::size(tQuantiles95) ? tQuantiles95[degreesOfFreedom - 1] : 1.96;
+        summary.confidenceHalfWidth = t * summary.stddev / std::sqrt(static_cast<double>(samples.size()));
+    }
+    return summary;
+}
+
+void TimeMeasurer::writeCsv(const std::string &filePath, const std::vector<MeasurementSummary> &summaries) {
+    std::ofstream file(filePath);
+    file << "graphName,metric,runs,mean,median,p90,p99,stddev,min,max,ci95\n";
+    for (const MeasurementSummary &summary: summaries) {
+        file << summary.graphName << ","
+             << summary.metric << ","
+             << summary.runs << ","
+             << summary.mean << ","
+             << summary.median << ","
+             << summary.p90 << ","
+             << summary.p99 << ","
+             << summary.stddev << ","
+             << summary.min << ","
+             << summary.max << ","
+             << summary.confidenceHalfWidth << "\n";
+    }
     file.close();
 }
 
-double TimeMeasurer::startMeasurement(std::vector<std::string> filePaths) {
-    std::ofstream file("algorithm_performance_data.csv");
-    file << "graphName,DFS_RI,DFS,BFL,TRO\n";
+/**
+ * quote a string for JSON output
+ */
+static std::string jsonString(const std::string &value) {
+    std::string quoted = "\"";
+    for (char c: value) {
+        if (c == '"' || c == '\\') {
+            quoted += '\\';
+        }
+        quoted += c;
+    }
+    return quoted + "\"";
+}
+
+void TimeMeasurer::writeJson(const std::string &filePath, const std::vector<MeasurementSummary> &summaries) {
+    std::ofstream file(filePath);
+    file << "[\n";
+    for (std::size_t i = 0; i < summaries.size(); ++i) {
+        const MeasurementSummary &summary = summaries[i];
+        file << "  {\"graphName\": " << jsonString(summary.graphName)
+             << ", \"metric\": " << jsonString(summary.metric)
+             << ", \"runs\": " << summary.runs
+             << ", \"mean\": " << summary.mean
+             << ", \"median\": " << summary.median
+             << ", \"p90\": " << summary.p90
+             << ", \"p99\": " << summary.p99
+             << ", \"stddev\": " << summary.stddev
+             << ", \"min\": " << summary.min
+             << ", \"max\": " << summary.max
+             << ", \"ci95\": " << summary.confidenceHalfWidth
+             << "}" << (i + 1 < summaries.size() ? "," : "") << "\n";
+    }
+    file << "]\n";
     file.close();
-    for (auto &filePath: filePaths) {
-        TimeMeasurer::measureGraphTRTime("algorithm_performance_data.csv", filePath);
+}
+
+bool TimeMeasurer::pinToCpu(int cpu) {
+#ifdef __linux__
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    CPU_SET(cpu, &cpuSet);
+    return sched_setaffinity(0, sizeof(cpuSet), &cpuSet) == 0;
+#else
+    (void) cpu;
+    return false;
+#endif
+}
+
+void TimeMeasurer::prefaultFile(const std::string &filePath) {
+    std::ifstream file(filePath, std::ios::binary);
+    std::vector<char> buffer(1 << 20);
+    while (file.read(buffer.data(), static_cast<std::streamsize>(buffer.size())) || file.gcount() > 0) {
     }
 }
 
-double TimeMeasurer::calculateMean(const std::vector<uint64_t> &data) {
+double TimeMeasurer::calculateMean(const std::vector<double> &data) {
     if (data.empty()) {
         return 0.0;
     }
-    uint64_t sum = std::accumulate(data.begin(), data.end(), uint64_t(0));
-    return static_cast<double>(sum) / data.size();
+    double sum = std::accumulate(data.begin(), data.end(), 0.0);
+    return sum / static_cast<double>(data.size());
 }
-
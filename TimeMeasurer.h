@@ -6,22 +6,134 @@
 #define ALGORITHMPROJECT_TIMEMEASURER_H
 
 
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include "GraphReorderer.h"
+
+/**
+ * @brief settings of a benchmark run
+ */
+struct BenchmarkConfig {
+    // untimed runs before measuring, to warm caches, the allocator and the branch predictors
+    unsigned warmupRuns = 2;
+    unsigned minRuns = 5;
+    unsigned maxRuns = 200;
+    // stop repeating once the 95% confidence interval half-width of every mean is within this fraction of the mean
+    double targetRelativeConfidence = 0.02;
+    // stop repeating after this much wall time per graph, even if the confidence target is not reached
+    double maxSecondsPerGraph = 60;
+    // pin the measuring thread to this CPU, -1 leaves scheduling to the OS
+    int cpu = -1;
+    // read the graph file and touch the parsed graph before timing, so that page faults are not measured
+    bool prefaultInputs = true;
+    // extra runs with a PhaseProfiler attached, reported per phase. They are separate from the timed runs,
+    // so that the profiling overhead does not leak into the headline numbers
+    unsigned phaseRuns = 3;
+    // measure peak RSS growth per phase in the phase runs
+    bool trackPhaseMemory = true;
+    // read cycles, instructions, cache, branch and dTLB misses per phase in the phase runs through perf_event_open.
+    // Counters the kernel refuses (e.g. in containers) are left out of the results
+    bool countHardwareEvents = true;
+    // when set, the phase runs export the TRO+ reduced graph there, to measure the export phase
+    std::string exportFilePath;
+    // renumber the nodes of every graph in this order before reducing it, timed as its own phase in the phase runs
+    NodeOrdering ordering = NodeOrdering::Input;
+    // result files, an empty path skips that format
+    std::string csvFilePath = "algorithm_performance_data.csv";
+    std::string jsonFilePath;
+};
+
+/**
+ * @brief statistics of the samples of one metric on one graph, in the unit of the metric (microseconds for times)
+ */
+struct MeasurementSummary {
+    std::string graphName;
+    std::string metric;
+    std::uint64_t runs = 0;
+    double mean = 0;
+    double median = 0;
+    double p90 = 0;
+    double p99 = 0;
+    double stddev = 0;
+    double min = 0;
+    double max = 0;
+    // half-width of the 95% confidence interval of the mean
+    double confidenceHalfWidth = 0;
+};
+
 class TimeMeasurer {
 public:
     /**
      * @brief measure time cost for different transitive algorithms and different reachability index construction approaches for a given graph file.
+     *
+     * Runs config.warmupRuns untimed iterations, then repeats until every metric reaches the confidence target,
+     * config.maxRuns or config.maxSecondsPerGraph. The metrics are the construction of each index and the
+     * redundancy check of each algorithm, each timed on its own. The graph is imported once and every iteration
+     * resets and reuses one ReductionWorkspace, so the timings do not include parsing or index allocation.
+     * Then config.phaseRuns profiled runs add one
+     * summary per phase and resource, named "<algorithm or index>/<phase>/<resource>". The resources are
+     * wall_us, cpu_us, peak_rss_delta_kb, allocations, allocated_bytes and, where available, cycles, instructions,
+     * ipc, cache_misses, branch_misses and dtlb_misses. The index sizes of DFS_RI and BFL follow as
+     * "<index>/index/<quantity>", and, in builds with ALGORITHMPROJECT_QUERY_STATISTICS, the query counters of
+     * both indices as "<index>/query/<counter>".
+     */
+    static std::vector<MeasurementSummary> measureGraphTRTime(const std::string &graphFilePath,
+                                                              const BenchmarkConfig &config);
+
+    /**
+     * @brief measure time cost for different transitive algorithms and different reachability index construction approachee for given graph files,
+     * and write the results to the CSV and JSON paths of config.
+     */
+    static std::vector<MeasurementSummary> startMeasurement(const std::vector<std::string> &filePaths,
+                                                            const BenchmarkConfig &config);
+
+    /**
+     * @brief repeat sample() until the confidence target of every metric is reached. sample() runs one iteration
+     * and returns one duration per metric.
+     * @return the samples of every metric, in the order sample() returns them
+     */
+    static std::vector<std::vector<double>> repeatUntilStable(const BenchmarkConfig &config, std::size_t numberOfMetrics,
+                                                              const std::function<std::vector<double>()> &sample);
+
+    /**
+     * @brief import, build, reduce with both algorithms and optionally export the given graph config.phaseRuns
+     * times with a PhaseProfiler attached, and summarize every phase and resource
+     */
+    static std::vector<MeasurementSummary> measureGraphPhases(const std::string &graphFilePath,
+                                                              const BenchmarkConfig &config);
+
+    /**
+     * @brief compute the statistics of the given samples
+     */
+    static MeasurementSummary summarize(const std::string &graphName, const std::string &metric,
+                                        std::vector<double> samples);
+
+    /**
+     * @brief write summaries as CSV, one row per graph and metric
+     */
+    static void writeCsv(const std::string &filePath, const std::vector<MeasurementSummary> &summaries);
+
+    /**
+     * @brief write summaries as a JSON array, one object per graph and metric
+     */
+    static void writeJson(const std::string &filePath, const std::vector<MeasurementSummary> &summaries);
+
+    /**
+     * @brief pin the calling thread to the given CPU. Returns false if pinning is not supported or failed.
      */
-    static void measureGraphTRTime(std::string performanceFilePath, std::string graphFilePath);
+    static bool pinToCpu(int cpu);
 
     /**
-     * @brief measure time cost for different transitive algorithms and different reachability index construction approachee for given graph files
+     * @brief read the whole file once, so that it is in the page cache before it is measured
      */
-    static double startMeasurement(std::vector<std::string> filePaths);
+    static void prefaultFile(const std::string &filePath);
 
     /**
      * @brief calculate mean value of data in given vector
      */
-    static double calculateMean(const std::vector<uint64_t> &data);
+    static double calculateMean(const std::vector<double> &data);
 };
 
 
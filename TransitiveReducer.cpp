@@ -0,0 +1,892 @@
+//
+// TransitiveReducer runs the transitive reduction algorithms on an immutable ReductionGraph with a reusable workspace
+//
+
+#include "TransitiveReducer.h"
+#include "BitKernels.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+
+#ifdef ALGORITHMPROJECT_QUERY_STATISTICS
+static constexpr bool countQueries = true;
+#else
+static constexpr bool countQueries = false;
+#endif
+
+
+void QueryStatistics::addQueryCounters(const QueryStatistics &other) {
+    bflQueries += other.bflQueries;
+    bflIdentityHits += other.bflIdentityHits;
+    bflIntervalHits += other.bflIntervalHits;
+    bflLabelCuts += other.bflLabelCuts;
+    bflExpandedNodes += other.bflExpandedNodes;
+    bflMaxDepth = std::max(bflMaxDepth, other.bflMaxDepth);
+    dfsRiQueries += other.dfsRiQueries;
+    dfsRiHits += other.dfsRiHits;
+    dfsRiProbes += other.dfsRiProbes;
+}
+
+
+// the instance ids of all constructed graphs
+static std::atomic<std::uint64_t> nextGraphInstanceId{1};
+
+template<typename Index>
+BasicReductionGraph<Index>::BasicReductionGraph(FinalGraphView finalGraph)
+        : nodeIds(finalGraph.nodeIds.begin(), finalGraph.nodeIds.end()),
+          edgeStarts(finalGraph.numberOfEdges()),
+          edgeEnds(finalGraph.numberOfEdges()),
+          outOffsets(finalGraph.numberOfNodes() + 1, 0),
+          outEdges(finalGraph.numberOfEdges()),
+          inOffsets(finalGraph.numberOfNodes() + 1, 0),
+          inEdges(finalGraph.numberOfEdges()) {
+    if (!fits(finalGraph.numberOfNodes(), finalGraph.numberOfEdges())) {
+        throw std::runtime_error("A graph of " + std::to_string(finalGraph.numberOfNodes()) + " nodes and "
+                                 + std::to_string(finalGraph.numberOfEdges()) + " edges exceeds the "
+                                 + std::to_string(8 * sizeof(Index)) + "-bit indices of the reduction graph");
+    }
+    instanceId = nextGraphInstanceId++;
+    std::unordered_map<std::uint64_t, std::uint64_t> nodeIndices;
+    nodeIndices.reserve(nodeIds.size());
+    for (std::uint64_t node = 0; node < nodeIds.size(); ++node) {
+        if (!nodeIndices.emplace(nodeIds[node], node).second) {
+            throw std::runtime_error("Duplicate node id " + std::to_string(nodeIds[node]));
+        }
+    }
+    auto indexOf = [&](std::uint64_t id, std::uint64_t edge) {
+        auto found = nodeIndices.find(id);
+        if (found == nodeIndices.end()) {
+            throw std::runtime_error("Edge " + std::to_string(finalGraph.edgeIds[edge]) + " refers to unknown node "
+                                     + std::to_string(id));
+        }
+        return found->second;
+    };
+    for (std::uint64_t edge = 0; edge < edgeStarts.size(); ++edge) {
+        edgeStarts[edge] = indexOf(finalGraph.edgeStartNodeIds[edge], edge);
+        edgeEnds[edge] = indexOf(finalGraph.edgeEndNodeIds[edge], edge);
+    }
+    buildAdjacency();
+}
+
+template<typename Index>
+BasicReductionGraph<Index>::BasicReductionGraph(const BasicReductionGraph &graph,
+                                                const std::vector<std::uint8_t> &isRemoved)
+        : nodeIds(graph.nodeIds),
+          outOffsets(graph.numberOfNodes() + 1, 0),
+          inOffsets(graph.numberOfNodes() + 1, 0) {
+    instanceId = nextGraphInstanceId++;
+    std::uint64_t numberOfEdges = graph.numberOfEdges() - std::count(isRemoved.begin(), isRemoved.end(), 1);
+    edgeStarts.reserve(numberOfEdges);
+    edgeEnds.reserve(numberOfEdges);
+    for (std::uint64_t edge = 0; edge < graph.numberOfEdges(); ++edge) {
+        if (!isRemoved[edge]) {
+            edgeStarts.push_back(graph.edgeStarts[edge]);
+            edgeEnds.push_back(graph.edgeEnds[edge]);
+        }
+    }
+    outEdges.resize(numberOfEdges);
+    inEdges.resize(numberOfEdges);
+    buildAdjacency();
+}
+
+template<typename Index>
+void BasicReductionGraph<Index>::buildAdjacency() {
+    for (std::uint64_t edge = 0; edge < edgeStarts.size(); ++edge) {
+        outOffsets[edgeStarts[edge] + 1]++;
+        inOffsets[edgeEnds[edge] + 1]++;
+    }
+    for (std::uint64_t node = 0; node < nodeIds.size(); ++node) {
+        outOffsets[node + 1] += outOffsets[node];
+        inOffsets[node + 1] += inOffsets[node];
+    }
+    // counting sort by start and end node, stable so that adjacency lists keep the input edge order
+    std::vector<Index> outPositions(outOffsets.begin(), outOffsets.end() - 1);
+    std::vector<Index> inPositions(inOffsets.begin(), inOffsets.end() - 1);
+    for (std::uint64_t edge = 0; edge < edgeStarts.size(); ++edge) {
+        outEdges[outPositions[edgeStarts[edge]]++] = edge;
+        inEdges[inPositions[edgeEnds[edge]]++] = edge;
+    }
+    for (std::uint64_t node = 0; node < nodeIds.size(); ++node) {
+        if (inDegree(node) == 0) {
+            startingNodes.push_back(node);
+        }
+    }
+}
+
+
+template<typename Index>
+void BasicReductionWorkspace<Index>::reset(const BasicReductionGraph<Index> &graph) {
+    if (!hasSchedule(graph)) {
+        scheduleGraphId = 0;
+    }
+    numberOfNodes = graph.numberOfNodes();
+    numberOfEdges = graph.numberOfEdges();
+    isDFSRIBuilt = false;
+    isBFLBuilt = false;
+    isRedundant.assign(numberOfEdges, 0);
+    queryStatistics = QueryStatistics();
+    for (BasicQueryState<Index> &state: queryStates) {
+        state.statistics = QueryStatistics();
+    }
+}
+
+template<typename Index>
+std::vector<std::uint64_t> BasicReductionWorkspace<Index>::redundancyBitmap() const {
+    std::vector<std::uint64_t> bitmap((isRedundant.size() + 63) / 64, 0);
+    for (std::uint64_t edge = 0; edge < isRedundant.size(); ++edge) {
+        bitmap[edge / 64] |= std::uint64_t(isRedundant[edge]) << (edge % 64);
+    }
+    return bitmap;
+}
+
+template<typename Index>
+std::uint64_t BasicReductionWorkspace<Index>::countRedundantEdges() const {
+    return std::count(isRedundant.begin(), isRedundant.end(), std::uint8_t(1));
+}
+
+
+/**
+ * the hash of a node id, mixing its bits so that neighbouring ids spread over the label bits
+ */
+static std::uint64_t mixNodeId(std::uint64_t x) {
+    x = (x ^ (x >> 30)) * UINT64_C(0xbf58476d1ce4e5b9);
+    x = (x ^ (x >> 27)) * UINT64_C(0x94d049bb133111eb);
+    return x ^ (x >> 31);
+}
+
+/**
+ * start a new query: every node stamped before counts as unvisited
+ */
+template<typename Index>
+static void beginQuery(BasicQueryState<Index> &state) {
+    if (++state.currentStamp == 0) {
+        std::fill(state.visitStamps.begin(), state.visitStamps.end(), 0);
+        state.currentStamp = 1;
+    }
+    state.stack.clear();
+}
+
+template<typename Index>
+static void requireWorkspace(const BasicReductionGraph<Index> &graph,
+                             const BasicReductionWorkspace<Index> &workspace) {
+    if (!workspace.fits(graph)) {
+        throw std::runtime_error("The workspace was not reset for this graph");
+    }
+}
+
+
+template<typename Index>
+void BasicTransitiveReducer<Index>::reduce(const Graph &graph, Workspace &workspace) const {
+    workspace.reset(graph);
+    if (options.index == ReachabilityIndex::DFS_RI) {
+        constructDFSRI(graph, workspace);
+    } else {
+        constructBFLRI(graph, workspace);
+    }
+    if (options.algorithm == ReductionAlgorithm::DFS) {
+        markRedundantEdges_DFS(graph, workspace, options.index);
+    } else {
+        markRedundantEdges_TROPlus(graph, workspace, options.index);
+    }
+}
+
+template<typename Index>
+void BasicTransitiveReducer<Index>::prepareQueryStates(Workspace &workspace, unsigned numberOfWorkers) {
+    if (workspace.queryStates.size() < numberOfWorkers) {
+        workspace.queryStates.resize(numberOfWorkers);
+    }
+    for (QueryState &state: workspace.queryStates) {
+        // stamps only grow, so the stamps left from a larger graph are all older than the current one
+        if (state.visitStamps.size() < workspace.numberOfNodes) {
+            state.visitStamps.resize(workspace.numberOfNodes, 0);
+        }
+    }
+}
+
+template<typename Index>
+void BasicTransitiveReducer<Index>::collectQueryStatistics(Workspace &workspace) {
+    for (QueryState &state: workspace.queryStates) {
+        workspace.queryStatistics.addQueryCounters(state.statistics);
+        state.statistics = QueryStatistics();
+    }
+}
+
+
+template<typename Index>
+void BasicTransitiveReducer<Index>::constructDFSRI(const Graph &graph, Workspace &workspace) const {
+    requireWorkspace(graph, workspace);
+    PhaseProfiler::Scope scope(workspace.profiler, Phase::IndexBuild, "DFS_RI");
+    std::uint64_t numberOfNodes = graph.numberOfNodes();
+    unsigned numberOfThreads = static_cast<unsigned>(std::min<std::uint64_t>(
+            resolveThreadCount(options.numberOfThreads), std::max<std::uint64_t>(numberOfNodes, 1)));
+    prepareQueryStates(workspace, numberOfThreads);
+    for (unsigned worker = 0; worker < numberOfThreads; ++worker) {
+        workspace.queryStates[worker].reached.clear();
+    }
+    workspace.closureOffsets.assign(numberOfNodes + 1, 0);
+    workspace.closureOwners.resize(numberOfNodes);
+    workspace.nodeCounters.resize(numberOfNodes);
+
+    // search the nodes reachable from every node, including itself, into the buffer of the searching thread
+    runParallel(numberOfNodes, numberOfThreads, [&](std::uint64_t source, unsigned worker) {
+        QueryState &state = workspace.queryStates[worker];
+        beginQuery(state);
+        std::uint64_t start = state.reached.size();
+        state.visitStamps[source] = state.currentStamp;
+        state.stack.emplace_back(source, 0);
+        while (!state.stack.empty()) {
+            std::uint64_t node = state.stack.back().first;
+            state.stack.pop_back();
+            state.reached.push_back(node);
+            for (std::uint64_t edge: graph.outgoingEdges(node)) {
+                std::uint64_t endNode = graph.edgeEnd(edge);
+                if (state.visitStamps[endNode] != state.currentStamp) {
+                    state.visitStamps[endNode] = state.currentStamp;
+                    state.stack.emplace_back(endNode, 0);
+                }
+            }
+        }
+        workspace.closureOwners[source] = worker;
+        workspace.nodeCounters[source] = start;
+        workspace.closureOffsets[source + 1] = state.reached.size() - start;
+    });
+    for (std::uint64_t node = 0; node < numberOfNodes; ++node) {
+        workspace.closureOffsets[node + 1] += workspace.closureOffsets[node];
+    }
+
+    // gather the closures into one array, sorted per node for the binary search of the queries
+    workspace.closureTargets.resize(workspace.closureOffsets[numberOfNodes]);
+    runParallel(numberOfNodes, numberOfThreads, [&](std::uint64_t node, unsigned) {
+        const std::vector<Index> &reached = workspace.queryStates[workspace.closureOwners[node]].reached;
+        auto first = reached.begin() + static_cast<std::ptrdiff_t>(workspace.nodeCounters[node]);
+        std::uint64_t size = workspace.closureOffsets[node + 1] - workspace.closureOffsets[node];
+        auto target = workspace.closureTargets.begin() + static_cast<std::ptrdiff_t>(workspace.closureOffsets[node]);
+        std::copy(first, first + static_cast<std::ptrdiff_t>(size), target);
+        std::sort(target, target + static_cast<std::ptrdiff_t>(size));
+    });
+    workspace.isDFSRIBuilt = true;
+}
+
+
+template<typename Index>
+void BasicTransitiveReducer<Index>::constructBFLRI(const Graph &graph, Workspace &workspace) const {
+    requireWorkspace(graph, workspace);
+    PhaseProfiler::Scope scope(workspace.profiler, Phase::IndexBuild, "BFL");
+    prepareQueryStates(workspace, 1);
+    postOrderTraverse(graph, workspace);
+    hashGroups(graph, workspace);
+    computeLabelOut(graph, workspace);
+    computeLabelIn(graph, workspace);
+    workspace.isBFLBuilt = true;
+}
+
+template<typename Index>
+void BasicTransitiveReducer<Index>::postOrderTraverse(const Graph &graph, Workspace &workspace) const {
+    std::uint64_t numberOfNodes = graph.numberOfNodes();
+    workspace.discoverTime.assign(numberOfNodes, 0);
+    workspace.finishTime.assign(numberOfNodes, 0);
+    workspace.postOrder.clear();
+    workspace.postOrder.reserve(numberOfNodes);
+
+    // depth first search from every starting node, the stack holds nodes and how many of their edges were followed
+    std::vector<std::pair<Index, Index>> &stack = workspace.queryStates[0].stack;
+    std::uint64_t current = 0;
+    for (Index startingNode: graph.getStartingNodes()) {
+        workspace.discoverTime[startingNode] = ++current;
+        stack.assign(1, {startingNode, 0});
+        while (!stack.empty()) {
+            auto &[node, followedEdges] = stack.back();
+            std::span<const Index> outgoingEdges = graph.outgoingEdges(node);
+            if (followedEdges < outgoingEdges.size()) {
+                std::uint64_t endNode = graph.edgeEnd(outgoingEdges[followedEdges++]);
+                if (workspace.discoverTime[endNode] == 0) {
+                    workspace.discoverTime[endNode] = ++current;
+                    stack.emplace_back(endNode, 0);
+                }
+            } else {
+                workspace.finishTime[node] = ++current;
+                workspace.postOrder.push_back(node);
+                stack.pop_back();
+            }
+        }
+    }
+    // nodes on cycles that no starting node reaches have no interval and are grouped first
+    if (workspace.postOrder.size() < numberOfNodes) {
+        std::vector<Index> unreached;
+        for (std::uint64_t node = 0; node < numberOfNodes; ++node) {
+            if (workspace.discoverTime[node] == 0) {
+                unreached.push_back(node);
+            }
+        }
+        workspace.postOrder.insert(workspace.postOrder.begin(), unreached.begin(), unreached.end());
+    }
+}
+
+template<typename Index>
+void BasicTransitiveReducer<Index>::hashGroups(const Graph &graph, Workspace &workspace) const {
+    // the nodes are grouped into intervals of the post-order, every group is hashed by its lowest node
+    std::uint64_t numberOfNodes = graph.numberOfNodes();
+    std::uint64_t intervalLength = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(std::ceil(
+            static_cast<double>(numberOfNodes) / static_cast<double>(options.numberOfIntervals))));
+    workspace.labelBit.resize(numberOfNodes);
+    std::uint64_t bit = 0;
+    for (std::uint64_t i = 0; i < numberOfNodes; ++i) {
+        if (i % intervalLength == 0) {
+            bit = mixNodeId(graph.nodeId(workspace.postOrder[i])) % options.numberOfHashValues;
+        }
+        workspace.labelBit[workspace.postOrder[i]] = bit;
+    }
+    workspace.labelWords = (options.numberOfHashValues + 63) / 64;
+}
+
+template<typename Index>
+void BasicTransitiveReducer<Index>::computeLabelOut(const Graph &graph, Workspace &workspace) const {
+    // successors finish before their predecessors, so in post-order their labels are complete
+    std::uint64_t words = workspace.labelWords;
+    workspace.labelOut.assign(graph.numberOfNodes() * words, 0);
+    for (std::uint64_t node: workspace.postOrder) {
+        std::uint64_t* label = workspace.labelOut.data() + node * words;
+        label[workspace.labelBit[node] / 64] |= std::uint64_t(1) << (workspace.labelBit[node] % 64);
+        for (std::uint64_t edge: graph.outgoingEdges(node)) {
+            BitKernels::orInto(label, workspace.labelOut.data() + graph.edgeEnd(edge) * words, words);
+        }
+    }
+}
+
+template<typename Index>
+void BasicTransitiveReducer<Index>::computeLabelIn(const Graph &graph, Workspace &workspace) const {
+    // predecessors finish after their successors, so in reverse post-order their labels are complete
+    std::uint64_t words = workspace.labelWords;
+    workspace.labelIn.assign(graph.numberOfNodes() * words, 0);
+    for (auto it = workspace.postOrder.rbegin(); it != workspace.postOrder.rend(); ++it) {
+        std::uint64_t node = *it;
+        std::uint64_t* label = workspace.labelIn.data() + node * words;
+        label[workspace.labelBit[node] / 64] |= std::uint64_t(1) << (workspace.labelBit[node] % 64);
+        for (std::uint64_t edge: graph.incomingEdges(node)) {
+            BitKernels::orInto(label, workspace.labelIn.data() + graph.edgeStart(edge) * words, words);
+        }
+    }
+}
+
+template<typename Index>
+bool BasicTransitiveReducer<Index>::isSubset(const std::uint64_t* a, const std::uint64_t* b,
+                                             std::uint64_t words) {
+    return BitKernels::isSubset(a, b, words);
+}
+
+
+template<typename Index>
+bool BasicTransitiveReducer<Index>::isReachable_DFSRI(const Workspace &workspace, QueryState &state,
+                                                      std::uint64_t a, std::uint64_t b) {
+    auto first = workspace.closureTargets.begin() + static_cast<std::ptrdiff_t>(workspace.closureOffsets[a]);
+    auto last = workspace.closureTargets.begin() + static_cast<std::ptrdiff_t>(workspace.closureOffsets[a + 1]);
+    bool isReachable = std::binary_search(first, last, b);
+    if constexpr (countQueries) {
+        state.statistics.dfsRiQueries++;
+        state.statistics.dfsRiHits += isReachable;
+        state.statistics.dfsRiProbes += std::bit_width(static_cast<std::uint64_t>(last - first));
+    }
+    return isReachable;
+}
+
+template<typename Index>
+bool BasicTransitiveReducer<Index>::isReachable_BFL(const Graph &graph, const Workspace &workspace,
+                                                    QueryState &state, std::uint64_t a, std::uint64_t b) {
+    if constexpr (countQueries) {
+        state.statistics.bflQueries++;
+    }
+    std::uint64_t words = workspace.labelWords;
+    const std::uint64_t* labelOutB = workspace.labelOut.data() + b * words;
+    const std::uint64_t* labelInB = workspace.labelIn.data() + b * words;
+    beginQuery(state);
+    state.stack.emplace_back(a, 1);
+    while (!state.stack.empty()) {
+        auto [node, depth] = state.stack.back();
+        state.stack.pop_back();
+        if (state.visitStamps[node] == state.currentStamp) {
+            continue;
+        }
+        if constexpr (countQueries) {
+            state.statistics.bflMaxDepth = std::max<std::uint64_t>(state.statistics.bflMaxDepth, depth);
+        }
+        if (node == b) {
+            if constexpr (countQueries) {
+                state.statistics.bflIdentityHits++;
+            }
+            return true;
+        }
+        state.visitStamps[node] = state.currentStamp;
+        if (workspace.discoverTime[node] < workspace.discoverTime[b]
+            && workspace.finishTime[node] > workspace.finishTime[b]) {
+            if constexpr (countQueries) {
+                state.statistics.bflIntervalHits++;
+            }
+            return true;
+        } else if (!isSubset(labelOutB, workspace.labelOut.data() + node * words, words)
+                   || !isSubset(workspace.labelIn.data() + node * words, labelInB, words)) {
+            if constexpr (countQueries) {
+                state.statistics.bflLabelCuts++;
+            }
+        } else {
+            if constexpr (countQueries) {
+                state.statistics.bflExpandedNodes++;
+            }
+            // pushed in reverse, so the successors are searched in adjacency order
+            std::span<const Index> outgoingEdges = graph.outgoingEdges(node);
+            for (auto it = outgoingEdges.rbegin(); it != outgoingEdges.rend(); ++it) {
+                std::uint64_t endNode = graph.edgeEnd(*it);
+                if (state.visitStamps[endNode] != state.currentStamp) {
+                    state.stack.emplace_back(endNode, depth + 1);
+                }
+            }
+        }
+    }
+    return false;
+}
+
+template<typename Index>
+bool BasicTransitiveReducer<Index>::isReachable(const Graph &graph, const Workspace &workspace,
+                                                QueryState &state, ReachabilityIndex index, std::uint64_t a,
+                                                std::uint64_t b) const {
+    if (index == ReachabilityIndex::BFL) {
+        return isReachable_BFL(graph, workspace, state, a, b);
+    }
+    return isReachable_DFSRI(workspace, state, a, b);
+}
+
+/**
+ * throws if the index a redundancy check queries has not been constructed for the current graph
+ */
+template<typename Index>
+static void requireIndex(const BasicReductionWorkspace<Index> &workspace, ReachabilityIndex index) {
+    if (index == ReachabilityIndex::DFS_RI && !workspace.hasDFSRI()) {
+        throw std::runtime_error("DFS_RI has not been constructed");
+    }
+    if (index == ReachabilityIndex::BFL && !workspace.hasBFL()) {
+        throw std::runtime_error("BFL_RI has not been constructed");
+    }
+}
+
+template<typename Index>
+bool BasicTransitiveReducer<Index>::queryReachability(const Graph &graph, Workspace &workspace,
+                                                      ReachabilityIndex index, std::uint64_t a,
+                                                      std::uint64_t b) const {
+    requireWorkspace(graph, workspace);
+    requireIndex(workspace, index);
+    prepareQueryStates(workspace, 1);
+    bool reachable = isReachable(graph, workspace, workspace.queryStates[0], index, a, b);
+    collectQueryStatistics(workspace);
+    return reachable;
+}
+
+
+template<typename Index>
+void BasicTransitiveReducer<Index>::markRedundantEdges_DFS(const Graph &graph, Workspace &workspace,
+                                                           ReachabilityIndex index) const {
+    //    For each vertex u in the graph:
+    //    For each of its successors v:
+    //    Check if there's a path from any other successor w of u to v
+    //    If such a path exists, mark the edge (u, v) as redundant
+    requireWorkspace(graph, workspace);
+    requireIndex(workspace, index);
+    PhaseProfiler::Scope scope(workspace.profiler, Phase::RedundancyCheck, "DFS");
+    std::fill(workspace.isRedundant.begin(), workspace.isRedundant.end(), 0);
+    unsigned numberOfThreads = static_cast<unsigned>(std::min<std::uint64_t>(
+            resolveThreadCount(options.numberOfThreads), std::max<std::uint64_t>(graph.numberOfNodes(), 1)));
+    prepareQueryStates(workspace, numberOfThreads);
+    // a node only reads and writes the flags of its own outgoing edges, so nodes are checked independently
+    runParallel(graph.numberOfNodes(), numberOfThreads, [&](std::uint64_t node, unsigned worker) {
+        QueryState &state = workspace.queryStates[worker];
+        std::span<const Index> outgoingEdges = graph.outgoingEdges(node);
+        for (std::uint64_t edge1: outgoingEdges) {
+            for (std::uint64_t edge2: outgoingEdges) {
+                if (edge1 != edge2
+                    && !workspace.isRedundant[edge2]
+                    && isReachable(graph, workspace, state, index, graph.edgeEnd(edge2), graph.edgeEnd(edge1))) {
+                    workspace.isRedundant[edge1] = 1;
+                    break;
+                }
+            }
+        }
+    });
+    collectQueryStatistics(workspace);
+}
+
+
+template<typename Index>
+void BasicTransitiveReducer<Index>::topoSort(const Graph &graph, Workspace &workspace) const {
+    requireWorkspace(graph, workspace);
+    workspace.scheduleGraphId = 0;
+    std::uint64_t numberOfNodes = graph.numberOfNodes();
+    workspace.topoOrder.assign(numberOfNodes, 0);
+    workspace.nodeCounters.resize(numberOfNodes);
+    for (std::uint64_t node = 0; node < numberOfNodes; ++node) {
+        workspace.nodeCounters[node] = graph.inDegree(node);
+    }
+    // first in first out, a node is ready once all of its incoming edges have been traversed
+    std::vector<Index> &queue = workspace.topoSortedNodes;
+    queue.assign(graph.getStartingNodes().begin(), graph.getStartingNodes().end());
+    queue.reserve(numberOfNodes);
+    for (std::uint64_t head = 0; head < queue.size(); ++head) {
+        std::uint64_t node = queue[head];
+        workspace.topoOrder[node] = head + 1;
+        for (std::uint64_t edge: graph.outgoingEdges(node)) {
+            std::uint64_t endNode = graph.edgeEnd(edge);
+            if (--workspace.nodeCounters[endNode] == 0) {
+                queue.push_back(endNode);
+            }
+        }
+    }
+    if (queue.size() != numberOfNodes) {
+        throw std::runtime_error("This graph contains loop");
+    }
+#ifndef NDEBUG
+    if (!isTopologicalOrder(graph, workspace.topoOrder)) {
+        throw std::runtime_error("topoSort produced an order that is not topological");
+    }
+#endif
+}
+
+/**
+ * the bounds of block i of count items split into numberOfBlocks nearly equal blocks
+ */
+static std::pair<std::uint64_t, std::uint64_t> blockRange(std::uint64_t count, std::uint64_t numberOfBlocks,
+                                                          std::uint64_t i) {
+    return {count * i / numberOfBlocks, count * (i + 1) / numberOfBlocks};
+}
+
+template<typename Index>
+bool BasicTransitiveReducer<Index>::isTopologicalOrder(const Graph &graph, const std::vector<Index> &topoOrder,
+                                                       unsigned numberOfThreads) {
+    if (topoOrder.size() != graph.numberOfNodes()) {
+        return false;
+    }
+    std::uint64_t numberOfEdges = graph.numberOfEdges();
+    numberOfThreads = static_cast<unsigned>(std::min<std::uint64_t>(resolveThreadCount(numberOfThreads),
+                                                                    std::max<std::uint64_t>(numberOfEdges, 1)));
+    std::vector<std::uint64_t> violations(numberOfThreads, 0);
+    runParallel(numberOfThreads, numberOfThreads, [&](std::uint64_t block, unsigned) {
+        auto [first, last] = blockRange(numberOfEdges, numberOfThreads, block);
+        std::uint64_t blockViolations = 0;
+        for (std::uint64_t edge = first; edge < last; ++edge) {
+            blockViolations += topoOrder[graph.edgeStart(edge)] >= topoOrder[graph.edgeEnd(edge)];
+        }
+        violations[block] = blockViolations;
+    });
+    return std::all_of(violations.begin(), violations.end(), [](std::uint64_t count) {
+        return count == 0;
+    });
+}
+
+template<typename Index>
+void BasicTransitiveReducer<Index>::sortEdges_TROPlus(const Graph &graph, Workspace &workspace) const {
+    requireWorkspace(graph, workspace);
+    std::uint64_t numberOfNodes = graph.numberOfNodes();
+    std::uint64_t numberOfEdges = graph.numberOfEdges();
+    unsigned numberOfThreads = static_cast<unsigned>(std::min<std::uint64_t>(
+            resolveThreadCount(options.numberOfThreads), std::max<std::uint64_t>(numberOfNodes, 1)));
+
+    //sort nodes based on in-degree or out-degree in ascending order. Degrees are at most the number of edges, so
+    //a stable counting sort does it in linear time, keeping equal degrees in node order with In-Node first.
+    //Every thread counts the degrees of one block of nodes, and the blocks scatter to disjoint ranges
+    std::uint64_t maxDegree = 0;
+    for (std::uint64_t node = 0; node < numberOfNodes; ++node) {
+        maxDegree = std::max({maxDegree, graph.inDegree(node), graph.outDegree(node)});
+    }
+    std::uint64_t numberOfDegrees = maxDegree + 1;
+    std::vector<Index> &degreeOffsets = workspace.degreeOffsets;
+    degreeOffsets.assign(numberOfThreads * numberOfDegrees, 0);
+    runParallel(numberOfThreads, numberOfThreads, [&](std::uint64_t block, unsigned) {
+        auto [first, last] = blockRange(numberOfNodes, numberOfThreads, block);
+        Index* counts = degreeOffsets.data() + block * numberOfDegrees;
+        for (std::uint64_t node = first; node < last; ++node) {
+            counts[graph.inDegree(node)]++;
+            counts[graph.outDegree(node)]++;
+        }
+    });
+    std::uint64_t offset = 0;
+    for (std::uint64_t degree = 0; degree < numberOfDegrees; ++degree) {
+        for (std::uint64_t block = 0; block < numberOfThreads; ++block) {
+            std::uint64_t count = degreeOffsets[block * numberOfDegrees + degree];
+            degreeOffsets[block * numberOfDegrees + degree] = offset;
+            offset += count;
+        }
+    }
+    std::vector<Index> &entries = workspace.scheduleEntries;
+    entries.resize(2 * numberOfNodes);
+    runParallel(numberOfThreads, numberOfThreads, [&](std::uint64_t block, unsigned) {
+        auto [first, last] = blockRange(numberOfNodes, numberOfThreads, block);
+        Index* positions = degreeOffsets.data() + block * numberOfDegrees;
+        for (std::uint64_t node = first; node < last; ++node) {
+            entries[positions[graph.inDegree(node)]++] = 2 * node + 1;
+            entries[positions[graph.outDegree(node)]++] = 2 * node;
+        }
+    });
+
+    workspace.sortedIncomingEdges.resize(numberOfEdges);
+    workspace.sortedOutgoingEdges.resize(numberOfEdges);
+    workspace.schedule.resize(numberOfEdges);
+    workspace.scheduleIsIn.resize(numberOfEdges);
+    if (numberOfThreads == 1) {
+        sortAdjacency_TROPlus(graph, workspace);
+        mergeSchedule_TROPlus(graph, workspace);
+    } else {
+        sortAdjacencyParallel_TROPlus(graph, workspace, numberOfThreads);
+        mergeScheduleParallel_TROPlus(graph, workspace, numberOfThreads);
+    }
+    workspace.scheduleGraphId = graph.getInstanceId();
+}
+
+template<typename Index>
+void BasicTransitiveReducer<Index>::sortAdjacency_TROPlus(const Graph &graph, Workspace &workspace) {
+    //sort the incoming edges of every node based on the descending topo-order of their starting nodes, and the
+    //outgoing edges based on the ascending topo-order of their end nodes. Visiting the nodes in topological order
+    //and appending their edges to the lists of the other endpoints sorts all lists at once
+    const std::vector<Index> &topoSortedNodes = workspace.topoSortedNodes;
+    std::vector<std::uint64_t> &positions = workspace.nodeCounters;
+    positions.resize(graph.numberOfNodes());
+    for (std::uint64_t node = 0; node < graph.numberOfNodes(); ++node) {
+        positions[node] = graph.inOffset(node);
+    }
+    for (auto it = topoSortedNodes.rbegin(); it != topoSortedNodes.rend(); ++it) {
+        for (std::uint64_t edge: graph.outgoingEdges(*it)) {
+            workspace.sortedIncomingEdges[positions[graph.edgeEnd(edge)]++] = edge;
+        }
+    }
+    for (std::uint64_t node = 0; node < graph.numberOfNodes(); ++node) {
+        positions[node] = graph.outOffset(node);
+    }
+    for (std::uint64_t node: topoSortedNodes) {
+        for (std::uint64_t edge: graph.incomingEdges(node)) {
+            workspace.sortedOutgoingEdges[positions[graph.edgeStart(edge)]++] = edge;
+        }
+    }
+}
+
+template<typename Index>
+void BasicTransitiveReducer<Index>::sortAdjacencyParallel_TROPlus(const Graph &graph, Workspace &workspace,
+                                                                  unsigned numberOfThreads) {
+    // every list is sorted on its own, parallel edges are ordered by edge index like in the sequential version
+    const std::vector<Index> &topoOrder = workspace.topoOrder;
+    runParallel(graph.numberOfNodes(), numberOfThreads, [&](std::uint64_t node, unsigned) {
+        std::span<const Index> incomingEdges = graph.incomingEdges(node);
+        auto sortedIncoming = workspace.sortedIncomingEdges.begin()
+                              + static_cast<std::ptrdiff_t>(graph.inOffset(node));
+        std::copy(incomingEdges.begin(), incomingEdges.end(), sortedIncoming);
+        std::sort(sortedIncoming, sortedIncoming + static_cast<std::ptrdiff_t>(incomingEdges.size()),
+                  [&](std::uint64_t edge1, std::uint64_t edge2) {
+                      std::uint64_t order1 = topoOrder[graph.edgeStart(edge1)];
+                      std::uint64_t order2 = topoOrder[graph.edgeStart(edge2)];
+                      return order1 != order2 ? order1 > order2 : edge1 < edge2;
+                  });
+        std::span<const Index> outgoingEdges = graph.outgoingEdges(node);
+        auto sortedOutgoing = workspace.sortedOutgoingEdges.begin()
+                              + static_cast<std::ptrdiff_t>(graph.outOffset(node));
+        std::copy(outgoingEdges.begin(), outgoingEdges.end(), sortedOutgoing);
+        std::sort(sortedOutgoing, sortedOutgoing + static_cast<std::ptrdiff_t>(outgoingEdges.size()),
+                  [&](std::uint64_t edge1, std::uint64_t edge2) {
+                      std::uint64_t order1 = topoOrder[graph.edgeEnd(edge1)];
+                      std::uint64_t order2 = topoOrder[graph.edgeEnd(edge2)];
+                      return order1 != order2 ? order1 < order2 : edge1 < edge2;
+                  });
+    });
+}
+
+template<typename Index>
+void BasicTransitiveReducer<Index>::mergeSchedule_TROPlus(const Graph &graph, Workspace &workspace) {
+    // sort edges based on how fast it can be processed in redundancy check, which depends on
+    // 1. in-degree of In-Node/out-degree of Out-Node
+    // 2. topo-order of starting node of incoming Edges of In-Node/topo-order of end node of outgoing Edges of Out-Node
+    // and add every edge the first time it is reached
+    std::vector<std::uint64_t> &scheduledEdgeBits = workspace.scheduledEdgeBits;
+    scheduledEdgeBits.assign((graph.numberOfEdges() + 63) / 64, 0);
+    std::uint64_t scheduled = 0;
+    for (std::uint64_t entry: workspace.scheduleEntries) {
+        std::uint64_t node = entry / 2;
+        bool isIn = entry % 2 == 1;
+        const Index* sortedEdges = isIn ? workspace.sortedIncomingEdges.data() + graph.inOffset(node)
+                                        : workspace.sortedOutgoingEdges.data() + graph.outOffset(node);
+        std::uint64_t degree = isIn ? graph.inDegree(node) : graph.outDegree(node);
+        for (std::uint64_t i = 0; i < degree; ++i) {
+            std::uint64_t edge = sortedEdges[i];
+            std::uint64_t bit = std::uint64_t(1) << (edge % 64);
+            if ((scheduledEdgeBits[edge / 64] & bit) == 0) {
+                scheduledEdgeBits[edge / 64] |= bit;
+                workspace.schedule[scheduled] = edge;
+                workspace.scheduleIsIn[scheduled] = isIn;
+                scheduled++;
+            }
+        }
+    }
+}
+
+template<typename Index>
+void BasicTransitiveReducer<Index>::mergeScheduleParallel_TROPlus(const Graph &graph, Workspace &workspace,
+                                                                  unsigned numberOfThreads) {
+    // every edge is listed twice, by the In-Node of its end node and by the Out-Node of its start node, and is
+    // scheduled by whichever of the two comes first. With the rank of every entry that is decided per edge, so
+    // blocks of entries count their edges, a prefix sum places the blocks, and they are written independently
+    const std::vector<Index> &entries = workspace.scheduleEntries;
+    std::vector<std::uint64_t> &entryRanks = workspace.nodeCounters;
+    entryRanks.resize(entries.size());
+    runParallel(entries.size(), numberOfThreads, [&](std::uint64_t rank, unsigned) {
+        entryRanks[entries[rank]] = rank;
+    });
+    auto forEachScheduledEdge = [&](std::uint64_t rank, auto &&onEdge) {
+        std::uint64_t node = entries[rank] / 2;
+        if (entries[rank] % 2 == 1) {
+            const Index* sortedEdges = workspace.sortedIncomingEdges.data() + graph.inOffset(node);
+            for (std::uint64_t i = 0; i < graph.inDegree(node); ++i) {
+                if (rank < entryRanks[2 * graph.edgeStart(sortedEdges[i])]) {
+                    onEdge(sortedEdges[i], true);
+                }
+            }
+        } else {
+            const Index* sortedEdges = workspace.sortedOutgoingEdges.data() + graph.outOffset(node);
+            for (std::uint64_t i = 0; i < graph.outDegree(node); ++i) {
+                if (rank < entryRanks[2 * graph.edgeEnd(sortedEdges[i]) + 1]) {
+                    onEdge(sortedEdges[i], false);
+                }
+            }
+        }
+    };
+    std::uint64_t numberOfBlocks = std::min<std::uint64_t>(4 * std::uint64_t(numberOfThreads),
+                                                           std::max<std::uint64_t>(entries.size(), 1));
+    std::vector<Index> &blockOffsets = workspace.degreeOffsets;
+    blockOffsets.assign(numberOfBlocks + 1, 0);
+    runParallel(numberOfBlocks, numberOfThreads, [&](std::uint64_t block, unsigned) {
+        auto [first, last] = blockRange(entries.size(), numberOfBlocks, block);
+        std::uint64_t count = 0;
+        for (std::uint64_t rank = first; rank < last; ++rank) {
+            forEachScheduledEdge(rank, [&](std::uint64_t, bool) {
+                count++;
+            });
+        }
+        blockOffsets[block + 1] = count;
+    });
+    for (std::uint64_t block = 0; block < numberOfBlocks; ++block) {
+        blockOffsets[block + 1] += blockOffsets[block];
+    }
+    runParallel(numberOfBlocks, numberOfThreads, [&](std::uint64_t block, unsigned) {
+        auto [first, last] = blockRange(entries.size(), numberOfBlocks, block);
+        std::uint64_t scheduled = blockOffsets[block];
+        for (std::uint64_t rank = first; rank < last; ++rank) {
+            forEachScheduledEdge(rank, [&](std::uint64_t edge, bool isIn) {
+                workspace.schedule[scheduled] = edge;
+                workspace.scheduleIsIn[scheduled] = isIn;
+                scheduled++;
+            });
+        }
+    });
+}
+
+template<typename Index>
+void BasicTransitiveReducer<Index>::markParallelEdges_TROPlus(const Graph &graph, Workspace &workspace) {
+    // the topological order comparisons of the check are strict, so a copy of an edge never implies another one
+    for (std::uint64_t node = 0; node < graph.numberOfNodes(); ++node) {
+        const Index* outgoingEdges = workspace.sortedOutgoingEdges.data() + graph.outOffset(node);
+        for (std::uint64_t i = 1; i < graph.outDegree(node); ++i) {
+            if (graph.edgeEnd(outgoingEdges[i - 1]) == graph.edgeEnd(outgoingEdges[i])) {
+                workspace.isRedundant[outgoingEdges[i - 1]] = 1;
+            }
+        }
+    }
+}
+
+template<typename Index>
+bool BasicTransitiveReducer<Index>::isRedundant_TROPlus(const Graph &graph, Workspace &workspace,
+                                                        ReachabilityIndex index, std::uint64_t edge) const {
+    QueryState &state = workspace.queryStates[0];
+    const std::vector<Index> &topoOrder = workspace.topoOrder;
+    std::uint64_t startNode = graph.edgeStart(edge);
+    std::uint64_t endNode = graph.edgeEnd(edge);
+    if (graph.outDegree(startNode) > graph.inDegree(endNode)) {
+        const Index* incomingEdges = workspace.sortedIncomingEdges.data() + graph.inOffset(endNode);
+        for (std::uint64_t i = 0; i < graph.inDegree(endNode); ++i) {
+            std::uint64_t incomingEdge = incomingEdges[i];
+            if (!workspace.isRedundant[incomingEdge]
+                && topoOrder[graph.edgeStart(incomingEdge)] > topoOrder[startNode]
+                && isReachable(graph, workspace, state, index, startNode, graph.edgeStart(incomingEdge)))
+                return true;
+        }
+    } else {
+        const Index* outgoingEdges = workspace.sortedOutgoingEdges.data() + graph.outOffset(startNode);
+        for (std::uint64_t i = 0; i < graph.outDegree(startNode); ++i) {
+            std::uint64_t outgoingEdge = outgoingEdges[i];
+            if (!workspace.isRedundant[outgoingEdge]
+                && topoOrder[graph.edgeEnd(outgoingEdge)] < topoOrder[endNode]
+                && isReachable(graph, workspace, state, index, graph.edgeEnd(outgoingEdge), endNode))
+                return true;
+        }
+    }
+    return false;
+}
+
+template<typename Index>
+void BasicTransitiveReducer<Index>::markRedundantEdges_TROPlus(const Graph &graph, Workspace &workspace,
+                                                               ReachabilityIndex index) const {
+    requireWorkspace(graph, workspace);
+    requireIndex(workspace, index);
+    prepareQueryStates(workspace, 1);
+    std::fill(workspace.isRedundant.begin(), workspace.isRedundant.end(), 0);
+    // the sorted edges are a permutation in the workspace, the adjacency lists of the graph stay in input order
+    if (!options.reuseSchedule || !workspace.hasSchedule(graph)) {
+        {
+            PhaseProfiler::Scope scope(workspace.profiler, Phase::TopoSort, "TRO+");
+            topoSort(graph, workspace);
+        }
+        PhaseProfiler::Scope scope(workspace.profiler, Phase::EdgeSort, "TRO+");
+        sortEdges_TROPlus(graph, workspace);
+    }
+
+    // check edges redundancy one edge at a time
+    PhaseProfiler::Scope checkScope(workspace.profiler, Phase::RedundancyCheck, "TRO+");
+    markParallelEdges_TROPlus(graph, workspace);
+    for (std::uint64_t edge: workspace.schedule) {
+        if (!workspace.isRedundant[edge]) {
+            workspace.isRedundant[edge] = isRedundant_TROPlus(graph, workspace, index, edge);
+        }
+    }
+    collectQueryStatistics(workspace);
+}
+
+
+template<typename Index>
+QueryStatistics BasicTransitiveReducer<Index>::getQueryStatistics(const Workspace &workspace) {
+    QueryStatistics statistics = workspace.queryStatistics;
+    auto bytesOf = [](const auto &array) {
+        return static_cast<std::uint64_t>(array.capacity() * sizeof(array[0]));
+    };
+    if (workspace.hasDFSRI()) {
+        statistics.dfsRiPairs = workspace.closureTargets.size();
+        statistics.dfsRiIndexBytes = bytesOf(workspace.closureOffsets) + bytesOf(workspace.closureTargets);
+    }
+    if (workspace.hasBFL()) {
+        for (const std::vector<std::uint64_t> *labels: {&workspace.labelOut, &workspace.labelIn}) {
+            statistics.bflLabelEntries += BitKernels::popcount(labels->data(), labels->size());
+        }
+        statistics.bflIndexBytes = bytesOf(workspace.discoverTime) + bytesOf(workspace.finishTime)
+                                   + bytesOf(workspace.postOrder) + bytesOf(workspace.labelBit)
+                                   + bytesOf(workspace.labelOut) + bytesOf(workspace.labelIn);
+    }
+    return statistics;
+}
+
+template<typename Index>
+bool BasicTransitiveReducer<Index>::isCountingQueries() {
+    return countQueries;
+}
+
+
+template class BasicReductionGraph<std::uint32_t>;
+template class BasicReductionGraph<std::uint64_t>;
+template class BasicReductionWorkspace<std::uint32_t>;
+template class BasicReductionWorkspace<std::uint64_t>;
+template class BasicTransitiveReducer<std::uint32_t>;
+template class BasicTransitiveReducer<std::uint64_t>;
@@ -0,0 +1,524 @@
+/**
+ * @file TransitiveReducer.h
+ * @brief This file contains the transitive reduction engine: ReductionGraph, an immutable compressed graph that
+ * can be shared between threads, ReductionWorkspace, the reusable state of one reduction run, and
+ * TransitiveReducer, which runs DFS or TRO+ with DFS_RI or BFL reachability indices on them.
+ */
+#ifndef ALGORITHMPROJECT_TRANSITIVEREDUCER_H
+#define ALGORITHMPROJECT_TRANSITIVEREDUCER_H
+
+
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <utility>
+#include <vector>
+#include "FinalGraph.h"
+#include "PhaseProfiler.h"
+
+/**
+ * @brief the transitive reduction algorithms
+ */
+enum class ReductionAlgorithm {
+    DFS,
+    TROPlus
+};
+
+/**
+ * @brief the reachability index a redundancy check queries. It has to be constructed before the check.
+ */
+enum class ReachabilityIndex {
+    DFS_RI,
+    BFL
+};
+
+/**
+ * @brief counters of the reachability queries of a run and the size of its indices. The query counters are only
+ * collected if the core library is built with ALGORITHMPROJECT_QUERY_STATISTICS, otherwise they stay 0.
+ * The index sizes are always filled in by TransitiveReducer::getQueryStatistics.
+ */
+struct QueryStatistics {
+    // BFL queries of the redundancy checks, and which check decided each visited node
+    std::uint64_t bflQueries = 0;
+    std::uint64_t bflIdentityHits = 0;
+    // positive cut: the target lies in the DFS interval of the node
+    std::uint64_t bflIntervalHits = 0;
+    // negative cut: the labels of the node and the target are not contained in each other
+    std::uint64_t bflLabelCuts = 0;
+    // no cut applied, so the successors of the node were searched
+    std::uint64_t bflExpandedNodes = 0;
+    std::uint64_t bflMaxDepth = 0;
+    // DFS_RI lookups of the redundancy checks, how many found a path, and the binary search steps they took
+    std::uint64_t dfsRiQueries = 0;
+    std::uint64_t dfsRiHits = 0;
+    std::uint64_t dfsRiProbes = 0;
+    // reachable pairs stored in DFS_RI
+    std::uint64_t dfsRiPairs = 0;
+    // hash values set in all BFL in- and out-labels
+    std::uint64_t bflLabelEntries = 0;
+    // heap bytes of the index arrays
+    std::uint64_t dfsRiIndexBytes = 0;
+    std::uint64_t bflIndexBytes = 0;
+
+    /**
+     * @brief add the query counters of other, used to merge the counters of parallel workers
+     */
+    void addQueryCounters(const QueryStatistics &other);
+};
+
+/**
+ * @brief immutable graph in compressed sparse row form. Nodes and edges are numbered densely in the order of the
+ * FinalGraph it was built from, so edge i of the reduction result is edge i of that FinalGraph. All methods are
+ * const, so one ReductionGraph can be reduced by several threads with separate workspaces at the same time.
+ * Node and edge indices, offsets and the per node arrays of the workspace are stored as Index: ReductionGraph
+ * uses 32 bits, which halves the arrays of all graphs that fit, and WideReductionGraph 64 bits.
+ */
+template<typename Index>
+class BasicReductionGraph {
+public:
+    /**
+     * @brief build the graph. Throws std::runtime_error if an edge refers to a node id that is not in the graph,
+     * or if the graph does not fit Index.
+     */
+    explicit BasicReductionGraph(FinalGraphView finalGraph);
+
+    /**
+     * @brief the subgraph with all nodes of graph and its edges not marked in isRemoved, in the same order, e.g.
+     * the reduced graph of a workspace's isRedundant flags. The node ids are not mapped again.
+     */
+    BasicReductionGraph(const BasicReductionGraph &graph, const std::vector<std::uint8_t> &isRemoved);
+
+    /**
+     * @brief whether a graph of this size can be stored with Index: its edges and twice its nodes, the largest
+     * DFS time, must be representable
+     */
+    static bool fits(std::uint64_t numberOfNodes, std::uint64_t numberOfEdges) {
+        constexpr std::uint64_t maxIndex = std::numeric_limits<Index>::max();
+        return numberOfNodes <= maxIndex / 2 && numberOfEdges <= maxIndex;
+    }
+
+    std::uint64_t numberOfNodes() const {
+        return nodeIds.size();
+    }
+
+    std::uint64_t numberOfEdges() const {
+        return edgeStarts.size();
+    }
+
+    /**
+     * @brief the id of a node in the FinalGraph
+     */
+    std::uint64_t nodeId(std::uint64_t node) const {
+        return nodeIds[node];
+    }
+
+    std::uint64_t edgeStart(std::uint64_t edge) const {
+        return edgeStarts[edge];
+    }
+
+    std::uint64_t edgeEnd(std::uint64_t edge) const {
+        return edgeEnds[edge];
+    }
+
+    /**
+     * @brief indices of the outgoing edges of a node, in input order
+     */
+    std::span<const Index> outgoingEdges(std::uint64_t node) const {
+        return {outEdges.data() + outOffsets[node], outEdges.data() + outOffsets[node + 1]};
+    }
+
+    /**
+     * @brief indices of the incoming edges of a node, in input order
+     */
+    std::span<const Index> incomingEdges(std::uint64_t node) const {
+        return {inEdges.data() + inOffsets[node], inEdges.data() + inOffsets[node + 1]};
+    }
+
+    std::uint64_t outDegree(std::uint64_t node) const {
+        return outOffsets[node + 1] - outOffsets[node];
+    }
+
+    std::uint64_t inDegree(std::uint64_t node) const {
+        return inOffsets[node + 1] - inOffsets[node];
+    }
+
+    std::uint64_t outOffset(std::uint64_t node) const {
+        return outOffsets[node];
+    }
+
+    std::uint64_t inOffset(std::uint64_t node) const {
+        return inOffsets[node];
+    }
+
+    /**
+     * @brief nodes without incoming edges, in node order
+     */
+    const std::vector<Index> &getStartingNodes() const {
+        return startingNodes;
+    }
+
+    /**
+     * @brief a number unique to every constructed graph and shared by its copies, so that a workspace can tell
+     * whether its cached results were computed for this graph
+     */
+    std::uint64_t getInstanceId() const {
+        return instanceId;
+    }
+
+private:
+    /**
+     * @brief fill the adjacency lists and the starting nodes from edgeStarts and edgeEnds
+     */
+    void buildAdjacency();
+
+    std::uint64_t instanceId;
+    std::vector<std::uint64_t> nodeIds;
+    std::vector<Index> edgeStarts;
+    std::vector<Index> edgeEnds;
+    std::vector<Index> outOffsets;
+    std::vector<Index> outEdges;
+    std::vector<Index> inOffsets;
+    std::vector<Index> inEdges;
+    std::vector<Index> startingNodes;
+};
+
+/**
+ * @brief scratch state of the BFL queries of one thread
+ */
+template<typename Index>
+struct BasicQueryState {
+    // a node is visited in the current query if its stamp equals currentStamp
+    std::vector<std::uint32_t> visitStamps;
+    std::uint32_t currentStamp = 0;
+    // nodes to search and their recursion depth
+    std::vector<std::pair<Index, Index>> stack;
+    // nodes found by this thread while building DFS_RI, before they are copied to the closure lists
+    std::vector<Index> reached;
+    QueryStatistics statistics;
+};
+
+template<typename Index>
+class BasicTransitiveReducer;
+
+/**
+ * @brief the mutable state of reduction runs on one graph at a time: indices, topological order, edge schedule and
+ * results. The arrays only grow, so a workspace reused for graphs of similar size does not allocate again.
+ * A workspace must only be used by one reduction at a time.
+ */
+template<typename Index>
+class BasicReductionWorkspace {
+public:
+    // 1 for every edge the last redundancy check marked redundant
+    std::vector<std::uint8_t> isRedundant;
+
+    // DFS_RI: the nodes reachable from node u, sorted, are closureTargets[closureOffsets[u], closureOffsets[u + 1]).
+    // The closure can hold more pairs than Index counts, so its offsets are 64 bits wide
+    std::vector<std::uint64_t> closureOffsets;
+    std::vector<Index> closureTargets;
+
+    // BFL: DFS discover and finish times, nodes in post-order, and per node its own label bit and labelWords words
+    // of out- and in-labels
+    std::vector<Index> discoverTime;
+    std::vector<Index> finishTime;
+    std::vector<Index> postOrder;
+    std::vector<Index> labelBit;
+    std::uint64_t labelWords = 0;
+    std::vector<std::uint64_t> labelOut;
+    std::vector<std::uint64_t> labelIn;
+
+    // TRO+: topological order starting at 1 and the nodes in that order, the edge schedule of the redundancy
+    // check, whether each scheduled edge was added from its end node (In-Node) or its start node (Out-Node), and
+    // the adjacency lists sorted by topological order, stored at the offsets of the ReductionGraph
+    std::vector<Index> topoOrder;
+    std::vector<Index> topoSortedNodes;
+    std::vector<Index> schedule;
+    std::vector<std::uint8_t> scheduleIsIn;
+    std::vector<Index> sortedIncomingEdges;
+    std::vector<Index> sortedOutgoingEdges;
+
+    // one query state per worker thread
+    std::vector<BasicQueryState<Index>> queryStates;
+    // query counters since the last reset
+    QueryStatistics queryStatistics;
+    // when set, index construction, sorting and redundancy checks are recorded as phases in it
+    PhaseProfiler* profiler = nullptr;
+
+    /**
+     * @brief size the workspace for graph and clear the results, the indices and the query counters.
+     * Only the per-edge result flags are cleared, in one pass, the other arrays are overwritten when they are
+     * built. Once the workspace has run a graph of the same size, neither reset nor the algorithms allocate.
+     */
+    void reset(const BasicReductionGraph<Index> &graph);
+
+    /**
+     * @brief whether reset was called for a graph of this size
+     */
+    bool fits(const BasicReductionGraph<Index> &graph) const {
+        return numberOfNodes == graph.numberOfNodes() && numberOfEdges == graph.numberOfEdges();
+    }
+
+    /**
+     * @brief the redundancy flags packed into words, bit i % 64 of word i / 64 set if edge i is redundant
+     */
+    std::vector<std::uint64_t> redundancyBitmap() const;
+
+    std::uint64_t countRedundantEdges() const;
+
+    bool hasDFSRI() const {
+        return isDFSRIBuilt;
+    }
+
+    bool hasBFL() const {
+        return isBFLBuilt;
+    }
+
+    /**
+     * @brief whether topoOrder, the sorted adjacency lists and the TRO+ schedule were built for this graph
+     */
+    bool hasSchedule(const BasicReductionGraph<Index> &graph) const {
+        return scheduleGraphId == graph.getInstanceId();
+    }
+
+private:
+    // per node scratch of the traversals: remaining in-degree in topoSort, and while building DFS_RI the thread
+    // that found the closure and where it starts in that thread's buffer, which can exceed Index
+    std::vector<std::uint64_t> nodeCounters;
+    std::vector<unsigned> closureOwners;
+    // the nodes of the TRO+ schedule by degree, 2 * node + 1 for In-Nodes and 2 * node for Out-Nodes, the bucket
+    // offsets of the counting sort by degree per thread, and one bit per edge that is already scheduled
+    std::vector<Index> scheduleEntries;
+    std::vector<Index> degreeOffsets;
+    std::vector<std::uint64_t> scheduledEdgeBits;
+    std::uint64_t numberOfNodes = 0;
+    std::uint64_t numberOfEdges = 0;
+    bool isDFSRIBuilt = false;
+    bool isBFLBuilt = false;
+    // instance id of the graph the TRO+ schedule was built for, 0 for none. It depends on the graph only, so
+    // unlike the indices it is kept by reset for the same graph
+    std::uint64_t scheduleGraphId = 0;
+
+    friend class BasicTransitiveReducer<Index>;
+};
+
+/**
+ * @brief settings of a TransitiveReducer
+ */
+struct ReductionOptions {
+    ReductionAlgorithm algorithm = ReductionAlgorithm::TROPlus;
+    // index of the redundancy check of reduce()
+    ReachabilityIndex index = ReachabilityIndex::BFL;
+    // threads of the parallel steps (DFS_RI construction, the DFS redundancy check and the TRO+ edge schedule),
+    // 0 for all hardware threads
+    unsigned numberOfThreads = 1;
+    // BFL: number of post-order intervals nodes are grouped into, and number of label bits they are hashed to
+    std::uint64_t numberOfIntervals = 1600;
+    std::uint64_t numberOfHashValues = 160;
+    // TRO+: skip the topological sort and the edge schedule if the workspace still holds them for the graph. Off
+    // by default, so that every run, and every benchmark sample, does the whole algorithm
+    bool reuseSchedule = false;
+
+    /**
+     * @brief the options of an algorithm with the index it was designed for: DFS_RI for DFS and BFL for TRO+
+     */
+    static ReductionOptions forAlgorithm(ReductionAlgorithm algorithm) {
+        ReductionOptions options;
+        options.algorithm = algorithm;
+        options.index = algorithm == ReductionAlgorithm::DFS ? ReachabilityIndex::DFS_RI : ReachabilityIndex::BFL;
+        return options;
+    }
+};
+
+template<typename Index>
+class BasicTransitiveReducer {
+public:
+    using Graph = BasicReductionGraph<Index>;
+    using Workspace = BasicReductionWorkspace<Index>;
+    using QueryState = BasicQueryState<Index>;
+
+    explicit BasicTransitiveReducer(ReductionOptions options = {}) : options(options) {}
+
+    const ReductionOptions &getOptions() const {
+        return options;
+    }
+
+    /**
+     * @brief reset the workspace, build the index of the options and run their algorithm. The result is in
+     * workspace.isRedundant. Throws std::runtime_error if the graph contains a cycle.
+     */
+    void reduce(const Graph &graph, Workspace &workspace) const;
+
+    /**
+     * @brief build DFS_RI, the full reachability closure of every node
+     */
+    void constructDFSRI(const Graph &graph, Workspace &workspace) const;
+
+    /**
+     * @brief build BFL_RI: DFS intervals and hashed in- and out-labels
+     */
+    void constructBFLRI(const Graph &graph, Workspace &workspace) const;
+
+    /**
+     * @brief mark an edge (u, v) redundant if another successor w of u, over a non-redundant edge, reaches v
+     */
+    void markRedundantEdges_DFS(const Graph &graph, Workspace &workspace,
+                                ReachabilityIndex index) const;
+
+    /**
+     * @brief TRO+: topologically sort, order the edges by how fast they can be checked and check them one by one
+     */
+    void markRedundantEdges_TROPlus(const Graph &graph, Workspace &workspace,
+                                    ReachabilityIndex index) const;
+
+    /**
+     * @brief assign topological orders starting at 1 with Kahn's algorithm. Throws std::runtime_error on cycles.
+     * Debug builds check the result with isTopologicalOrder.
+     */
+    void topoSort(const Graph &graph, Workspace &workspace) const;
+
+    /**
+     * @brief whether topoOrder[start] < topoOrder[end] for every edge, in one pass over the edges split into a
+     * block per thread. The loop over a block has no early exit, so it vectorizes.
+     */
+    static bool isTopologicalOrder(const Graph &graph, const std::vector<Index> &topoOrder,
+                                   unsigned numberOfThreads = 1);
+
+    /**
+     * @brief build the TRO+ edge schedule and the sorted adjacency lists with counting sorts, in O(n + m) on one
+     * thread. On more threads the lists are sorted per node and the schedule is merged by blocks, with the same
+     * result. topoSort must have run.
+     */
+    void sortEdges_TROPlus(const Graph &graph, Workspace &workspace) const;
+
+    /**
+     * @brief check whether node a reaches node b with the given index, using the query state of worker 0
+     */
+    bool queryReachability(const Graph &graph, Workspace &workspace, ReachabilityIndex index,
+                           std::uint64_t a, std::uint64_t b) const;
+
+    /**
+     * @brief the query counters of the workspace and the size of its indices
+     */
+    static QueryStatistics getQueryStatistics(const Workspace &workspace);
+
+    /**
+     * @brief whether the core library was built with ALGORITHMPROJECT_QUERY_STATISTICS
+     */
+    static bool isCountingQueries();
+
+private:
+    ReductionOptions options;
+
+    /**
+     * @brief compute DFS discover and finish times and the post-order from the starting nodes
+     */
+    void postOrderTraverse(const Graph &graph, Workspace &workspace) const;
+
+    /**
+     * @brief group the nodes into post-order intervals and hash every group to one label bit
+     */
+    void hashGroups(const Graph &graph, Workspace &workspace) const;
+
+    /**
+     * @brief compute the BFL label of all the groups that every node can reach
+     */
+    void computeLabelOut(const Graph &graph, Workspace &workspace) const;
+
+    /**
+     * @brief compute the BFL label of all the groups that can reach every node
+     */
+    void computeLabelIn(const Graph &graph, Workspace &workspace) const;
+
+    /**
+     * @brief check whether label a is a subset of label b
+     */
+    static bool isSubset(const std::uint64_t* a, const std::uint64_t* b, std::uint64_t words);
+
+    /**
+     * @brief whether a reaches b by DFS_RI
+     */
+    static bool isReachable_DFSRI(const Workspace &workspace, QueryState &state, std::uint64_t a,
+                                  std::uint64_t b);
+
+    /**
+     * @brief whether a reaches b by BFL: the interval and label cuts decide, otherwise the successors are searched
+     */
+    static bool isReachable_BFL(const Graph &graph, const Workspace &workspace,
+                                QueryState &state, std::uint64_t a, std::uint64_t b);
+
+    bool isReachable(const Graph &graph, const Workspace &workspace, QueryState &state,
+                     ReachabilityIndex index, std::uint64_t a, std::uint64_t b) const;
+
+    /**
+     * @brief sort all adjacency lists by topological order in two linear passes over the nodes in that order
+     */
+    static void sortAdjacency_TROPlus(const Graph &graph, Workspace &workspace);
+
+    /**
+     * @brief sort the adjacency lists of every node on its own, the nodes distributed over the threads
+     */
+    static void sortAdjacencyParallel_TROPlus(const Graph &graph, Workspace &workspace,
+                                              unsigned numberOfThreads);
+
+    /**
+     * @brief append the edges of the scheduled nodes to the schedule, skipping edges that are already in it
+     */
+    static void mergeSchedule_TROPlus(const Graph &graph, Workspace &workspace);
+
+    /**
+     * @brief the same schedule as mergeSchedule_TROPlus, written by blocks of scheduled nodes in parallel
+     */
+    static void mergeScheduleParallel_TROPlus(const Graph &graph, Workspace &workspace,
+                                              unsigned numberOfThreads);
+
+    /**
+     * @brief mark all but the last copy of every group of parallel edges redundant, like the DFS check does. The
+     * sorted outgoing lists hold the copies next to each other in edge order, so this is one pass over them.
+     * sortEdges_TROPlus must have run.
+     */
+    static void markParallelEdges_TROPlus(const Graph &graph, Workspace &workspace);
+
+    /**
+     * @brief check if the edge is redundant, given the redundancy of the edges scheduled before it
+     */
+    bool isRedundant_TROPlus(const Graph &graph, Workspace &workspace, ReachabilityIndex index,
+                             std::uint64_t edge) const;
+
+    /**
+     * @brief the query states of numberOfWorkers threads, sized for the workspace's graph
+     */
+    static void prepareQueryStates(Workspace &workspace, unsigned numberOfWorkers);
+
+    /**
+     * @brief add the counters of all query states to the workspace and clear them
+     */
+    static void collectQueryStatistics(Workspace &workspace);
+
+    // the microbenchmarks time the private kernels one by one
+    friend class KernelBenchmarks;
+};
+
+// the members are defined and instantiated for both index widths in TransitiveReducer.cpp
+extern template class BasicReductionGraph<std::uint32_t>;
+extern template class BasicReductionGraph<std::uint64_t>;
+extern template class BasicReductionWorkspace<std::uint32_t>;
+extern template class BasicReductionWorkspace<std::uint64_t>;
+extern template class BasicTransitiveReducer<std::uint32_t>;
+extern template class BasicTransitiveReducer<std::uint64_t>;
+
+/**
+ * @brief the engine on 32-bit indices, for graphs with fewer than 2^31 nodes and 2^32 edges
+ */
+using ReductionGraph = BasicReductionGraph<std::uint32_t>;
+using QueryState = BasicQueryState<std::uint32_t>;
+using ReductionWorkspace = BasicReductionWorkspace<std::uint32_t>;
+using TransitiveReducer = BasicTransitiveReducer<std::uint32_t>;
+
+/**
+ * @brief the engine on 64-bit indices, for larger graphs
+ */
+using WideReductionGraph = BasicReductionGraph<std::uint64_t>;
+using WideReductionWorkspace = BasicReductionWorkspace<std::uint64_t>;
+using WideTransitiveReducer = BasicTransitiveReducer<std::uint64_t>;
+
+
+#endif //ALGORITHMPROJECT_TRANSITIVEREDUCER_H
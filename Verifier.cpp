@@ -1,44 +1,754 @@
 #include <string>
 #include <iostream>
+#include <algorithm>
+#include <bit>
+#include <filesystem>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <unordered_map>
 #include "Verifier.h"
+#include "BitKernels.h"
 #include "GraphParser.h"
+#include "Parallel.h"
+#include "PhaseProfiler.h"
 
 
-bool Verifier::crossCheckTRCorrectness(std::string filePath) {
-    FinalGraph* graph = GraphParser::importFinalGraph(filePath);
-    IntermediateGraph* intermediateGraph = GraphParser::parseToIntermediateGraph(graph);
-    intermediateGraph->markRedundantEdges_DFS();
-    intermediateGraph->markRedundantEdges_TROPlus(false);
-    for (const auto &item: intermediateGraph->edges) {
-        if (item->isRedundant_DFS != item->isRedundant_TROPlus) {
-            return false;
+std::vector<ReductionOptions> CrossValidationConfig::defaultEngines() {
+    std::vector<ReductionOptions> engines;
+    for (ReductionAlgorithm algorithm: {ReductionAlgorithm::DFS, ReductionAlgorithm::TROPlus}) {
+        for (ReachabilityIndex index: {ReachabilityIndex::DFS_RI, ReachabilityIndex::BFL}) {
+            ReductionOptions options;
+            options.algorithm = algorithm;
+            options.index = index;
+            engines.push_back(options);
         }
     }
-    return true;
+    return engines;
 }
 
-bool Verifier::verifyGraphTopoOrder(std::string fileName) {
-    FinalGraph* graph = GraphParser::importFinalGraph(fileName);
-    IntermediateGraph* intermediateGraph = GraphParser::parseToIntermediateGraph(graph);
-    for (IntermediateNode* node: intermediateGraph->startingNodes) {
-        if (!verifyNodeTopoOrder(node))
-            return false;
+/**
+ * scratch of the graph searches of one oracle thread
+ */
+struct SearchState {
+    // a node is visited in the current search if its stamp equals currentStamp
+    std::vector<std::uint32_t> visitStamps;
+    std::uint32_t currentStamp = 0;
+    std::vector<std::uint64_t> queue;
+    // the edge every visited node was first reached over
+    std::vector<std::uint64_t> predecessors;
+};
+
+/**
+ * nodes in topological order by Kahn's algorithm, computed here so that the oracle does not depend on
+ * TransitiveReducer::topoSort
+ */
+template<typename Index>
+static std::vector<std::uint64_t> oracleTopoSort(const BasicReductionGraph<Index> &graph) {
+    std::vector<std::uint64_t> remainingInDegree(graph.numberOfNodes());
+    std::vector<std::uint64_t> sortedNodes;
+    sortedNodes.reserve(graph.numberOfNodes());
+    for (std::uint64_t node = 0; node < graph.numberOfNodes(); ++node) {
+        remainingInDegree[node] = graph.inDegree(node);
+        if (remainingInDegree[node] == 0) {
+            sortedNodes.push_back(node);
+        }
     }
-    return true;
+    for (std::uint64_t head = 0; head < sortedNodes.size(); ++head) {
+        for (std::uint64_t edge: graph.outgoingEdges(sortedNodes[head])) {
+            if (--remainingInDegree[graph.edgeEnd(edge)] == 0) {
+                sortedNodes.push_back(graph.edgeEnd(edge));
+            }
+        }
+    }
+    if (sortedNodes.size() != graph.numberOfNodes()) {
+        throw std::runtime_error("This graph contains loop");
+    }
+    return sortedNodes;
 }
 
-bool Verifier::verifyNodeTopoOrder(IntermediateNode* node) {
-    for (IntermediateEdge* edge: node->outgoingEdges) {
-        if (edge->endNode->topoOrder < node->topoOrder || !verifyNodeTopoOrder(edge->endNode))
-            return false;
+// no edge, for searches that may use every edge
+static constexpr std::uint64_t noEdge = UINT64_MAX;
+
+enum class SearchResult {
+    Found,
+    NotFound,
+    // more than the allowed number of nodes were visited
+    Abandoned
+};
+
+/**
+ * post-order number of a node in a depth first traversal, and the smallest numbers in its traversal subtree and
+ * among all nodes it reaches. The subtree fills [treeLow, postNumber], the nodes it reaches lie in
+ * [reachLow, postNumber].
+ */
+template<typename Index>
+struct IntervalLabel {
+    static constexpr Index none = std::numeric_limits<Index>::max();
+
+    Index postNumber = none;
+    Index treeLow = none;
+    Index reachLow = none;
+};
+
+/**
+ * the reduced graph certifyReduction checks, with the ranks of a topological order and interval labels of one
+ * depth first traversal
+ */
+template<typename Index>
+struct ReducedGraphIndex {
+    const BasicReductionGraph<Index> &graph;
+    std::vector<std::uint64_t> sortedNodes;
+    std::vector<Index> topoRanks;
+    std::vector<IntervalLabel<Index>> labels;
+
+    /**
+     * whether endNode is reachable from node over edges of the traversal tree
+     */
+    bool reachesOverTree(std::uint64_t node, std::uint64_t endNode) const {
+        std::uint64_t endNumber = labels[endNode].postNumber;
+        return labels[node].treeLow <= endNumber && endNumber < labels[node].postNumber;
     }
-    return true;
+
+    /**
+     * whether the labels rule out that endNode is reachable from node
+     */
+    bool cannotReach(std::uint64_t node, std::uint64_t endNode) const {
+        std::uint64_t endNumber = labels[endNode].postNumber;
+        return endNumber < labels[node].reachLow || endNumber > labels[node].postNumber;
+    }
+};
+
+/**
+ * index graph, given its nodes in an order that must be topological
+ */
+template<typename Index>
+static ReducedGraphIndex<Index> indexReducedGraph(const BasicReductionGraph<Index> &graph,
+                                                  std::vector<std::uint64_t> sortedNodes) {
+    std::uint64_t numberOfNodes = graph.numberOfNodes();
+    ReducedGraphIndex<Index> index{graph, std::move(sortedNodes), {}, {}};
+    if (index.sortedNodes.size() != numberOfNodes) {
+        throw std::runtime_error("The topological order does not list every node of the reduced graph");
+    }
+    constexpr Index noRank = std::numeric_limits<Index>::max();
+    index.topoRanks.assign(numberOfNodes, noRank);
+    for (std::uint64_t rank = 0; rank < numberOfNodes; ++rank) {
+        if (index.topoRanks[index.sortedNodes[rank]] != noRank) {
+            throw std::runtime_error("The topological order lists a node of the reduced graph twice");
+        }
+        index.topoRanks[index.sortedNodes[rank]] = rank;
+    }
+    for (std::uint64_t edge = 0; edge < graph.numberOfEdges(); ++edge) {
+        if (index.topoRanks[graph.edgeStart(edge)] >= index.topoRanks[graph.edgeEnd(edge)]) {
+            throw std::runtime_error("The topological order does not order the edges of the reduced graph");
+        }
+    }
+
+    // depth first search from every node in topological order that is not reached yet, the stack holds nodes
+    // and how many of their edges were followed. Nodes a node reaches finish before it in a DAG, so their
+    // reach lows are known when it finishes
+    index.labels.assign(numberOfNodes, IntervalLabel<Index>());
+    std::vector<std::pair<std::uint64_t, std::uint64_t>> stack;
+    std::uint64_t nextNumber = 0;
+    for (std::uint64_t root: index.sortedNodes) {
+        if (index.labels[root].treeLow != IntervalLabel<Index>::none) {
+            continue;
+        }
+        index.labels[root].treeLow = nextNumber;
+        stack.assign(1, {root, 0});
+        while (!stack.empty()) {
+            auto &[node, followedEdges] = stack.back();
+            std::span<const Index> outgoingEdges = graph.outgoingEdges(node);
+            if (followedEdges < outgoingEdges.size()) {
+                std::uint64_t edge = outgoingEdges[followedEdges++];
+                IntervalLabel<Index> &endLabel = index.labels[graph.edgeEnd(edge)];
+                if (endLabel.treeLow == IntervalLabel<Index>::none) {
+                    endLabel.treeLow = nextNumber;
+                    stack.emplace_back(graph.edgeEnd(edge), 0);
+                }
+                continue;
+            }
+            IntervalLabel<Index> &label = index.labels[node];
+            label.reachLow = nextNumber;
+            for (std::uint64_t edge: outgoingEdges) {
+                label.reachLow = std::min(label.reachLow, index.labels[graph.edgeEnd(edge)].reachLow);
+            }
+            label.postNumber = nextNumber++;
+            stack.pop_back();
+        }
+    }
+    return index;
+}
+
+/**
+ * breadth first search for a path from startNode to endNode that does not use skippedEdge, and with
+ * isSkippingParallelEdges no edge from startNode to endNode either. Nodes after endNode in topological order
+ * cannot lead to it and are not searched. The path is stored as node ids if path is set. The labels of reduced,
+ * the index of graph, settle nodes without searching them, which needs path to be unset.
+ */
+template<typename Index>
+static SearchResult searchPath(const BasicReductionGraph<Index> &graph, const std::vector<Index> &topoRanks,
+                               SearchState &state, std::uint64_t startNode, std::uint64_t endNode,
+                               std::uint64_t skippedEdge, bool isSkippingParallelEdges,
+                               std::vector<std::uint64_t>* path, std::uint64_t maxVisitedNodes = UINT64_MAX,
+                               const ReducedGraphIndex<Index>* reduced = nullptr) {
+    if (state.visitStamps.size() < graph.numberOfNodes()) {
+        state.visitStamps.assign(graph.numberOfNodes(), 0);
+        state.predecessors.resize(graph.numberOfNodes());
+        state.currentStamp = 0;
+    }
+    if (++state.currentStamp == 0) {
+        std::fill(state.visitStamps.begin(), state.visitStamps.end(), 0);
+        state.currentStamp = 1;
+    }
+    // without skipped edges, the labels of startNode itself may settle the search
+    if (reduced && maxVisitedNodes > 0 && skippedEdge == noEdge && !isSkippingParallelEdges
+        && reduced->reachesOverTree(startNode, endNode)) {
+        return SearchResult::Found;
+    }
+    state.queue.clear();
+    state.queue.push_back(startNode);
+    state.visitStamps[startNode] = state.currentStamp;
+    for (std::uint64_t head = 0; head < state.queue.size(); ++head) {
+        if (head == maxVisitedNodes) {
+            return SearchResult::Abandoned;
+        }
+        std::uint64_t node = state.queue[head];
+        for (std::uint64_t nextEdge: graph.outgoingEdges(node)) {
+            std::uint64_t nextNode = graph.edgeEnd(nextEdge);
+            if (nextEdge == skippedEdge || (isSkippingParallelEdges && node == startNode && nextNode == endNode)
+                || topoRanks[nextNode] > topoRanks[endNode]) {
+                continue;
+            }
+            if (reduced && nextNode != endNode) {
+                if (reduced->reachesOverTree(nextNode, endNode)) {
+                    return SearchResult::Found;
+                }
+                if (reduced->cannotReach(nextNode, endNode)) {
+                    continue;
+                }
+            }
+            if (state.visitStamps[nextNode] == state.currentStamp) {
+                continue;
+            }
+            state.visitStamps[nextNode] = state.currentStamp;
+            if (path) {
+                state.predecessors[nextNode] = nextEdge;
+            }
+            if (nextNode == endNode) {
+                if (path) {
+                    path->clear();
+                    for (std::uint64_t pathNode = endNode; pathNode != startNode;
+                         pathNode = graph.edgeStart(state.predecessors[pathNode])) {
+                        path->push_back(graph.nodeId(pathNode));
+                    }
+                    path->push_back(graph.nodeId(startNode));
+                    std::reverse(path->begin(), path->end());
+                }
+                return SearchResult::Found;
+            }
+            state.queue.push_back(nextNode);
+        }
+    }
+    return SearchResult::NotFound;
+}
+
+/**
+ * the reachability closure as one row of words bits per node, bit v of row u set if v is reachable from u over
+ * one or more edges. Nodes of the same height, the longest path to a sink, cannot reach each other, so the rows
+ * of one height are built in parallel from the rows of the lower ones.
+ */
+static std::vector<std::uint64_t> buildClosure(const ReductionGraph &graph,
+                                               const std::vector<std::uint64_t> &sortedNodes, std::uint64_t words,
+                                               unsigned numberOfThreads) {
+    std::uint64_t numberOfNodes = graph.numberOfNodes();
+    std::vector<std::uint64_t> heights(numberOfNodes, 0);
+    std::uint64_t maxHeight = 0;
+    for (auto it = sortedNodes.rbegin(); it != sortedNodes.rend(); ++it) {
+        for (std::uint64_t edge: graph.outgoingEdges(*it)) {
+            heights[*it] = std::max(heights[*it], heights[graph.edgeEnd(edge)] + 1);
+        }
+        maxHeight = std::max(maxHeight, heights[*it]);
+    }
+    std::vector<std::uint64_t> levelOffsets(maxHeight + 2, 0);
+    for (std::uint64_t height: heights) {
+        levelOffsets[height + 1]++;
+    }
+    for (std::uint64_t height = 0; height <= maxHeight; ++height) {
+        levelOffsets[height + 1] += levelOffsets[height];
+    }
+    std::vector<std::uint64_t> levelNodes(numberOfNodes);
+    std::vector<std::uint64_t> positions(levelOffsets.begin(), levelOffsets.end() - 1);
+    for (std::uint64_t node = 0; node < numberOfNodes; ++node) {
+        levelNodes[positions[heights[node]]++] = node;
+    }
+
+    std::vector<std::uint64_t> closure(numberOfNodes * words, 0);
+    for (std::uint64_t height = 0; height <= maxHeight && numberOfNodes > 0; ++height) {
+        std::uint64_t first = levelOffsets[height];
+        runParallel(levelOffsets[height + 1] - first, numberOfThreads, [&](std::uint64_t i, unsigned) {
+            std::uint64_t node = levelNodes[first + i];
+            std::uint64_t* row = closure.data() + node * words;
+            for (std::uint64_t edge: graph.outgoingEdges(node)) {
+                std::uint64_t endNode = graph.edgeEnd(edge);
+                row[endNode / 64] |= std::uint64_t(1) << (endNode % 64);
+                BitKernels::orInto(row, closure.data() + endNode * words, words);
+            }
+        });
+    }
+    return closure;
+}
+
+/**
+ * whether the redundancy of edge contradicts the oracle, given whether its end node is reachable from its start
+ * node over two or more edges
+ */
+static bool contradictsOracle(const ReductionGraph &graph, const std::vector<std::uint8_t> &isRedundant,
+                              std::uint64_t edge, bool isImplied) {
+    if (isImplied) {
+        return !isRedundant[edge];
+    }
+    return !Verifier::keepsOneParallelEdge(graph, graph.edgeStart(edge), graph.edgeEnd(edge), isRedundant);
+}
+
+template<typename Index>
+bool Verifier::keepsOneParallelEdge(const BasicReductionGraph<Index> &graph, std::uint64_t startNode,
+                                    std::uint64_t endNode, const std::vector<std::uint8_t> &isRedundant) {
+    std::uint64_t keptEdges = 0;
+    for (std::uint64_t edge: graph.outgoingEdges(startNode)) {
+        if (graph.edgeEnd(edge) == endNode && (isRedundant.empty() || !isRedundant[edge])) {
+            keptEdges++;
+        }
+    }
+    return keptEdges == 1;
+}
+
+template bool Verifier::keepsOneParallelEdge(const ReductionGraph &, std::uint64_t, std::uint64_t,
+                                             const std::vector<std::uint8_t> &);
+template bool Verifier::keepsOneParallelEdge(const WideReductionGraph &, std::uint64_t, std::uint64_t,
+                                             const std::vector<std::uint8_t> &);
+
+/**
+ * number of edges whose bits differ between two redundancy bitmaps
+ */
+static std::uint64_t countDifferences(const std::vector<std::uint64_t> &bitmap1,
+                                      const std::vector<std::uint64_t> &bitmap2) {
+    return BitKernels::xorPopcount(bitmap1.data(), bitmap2.data(), bitmap1.size());
+}
+
+std::string Verifier::engineName(const ReductionOptions &options) {
+    return std::string(options.algorithm == ReductionAlgorithm::DFS ? "DFS" : "TRO+")
+           + (options.index == ReachabilityIndex::DFS_RI ? "/DFS_RI" : "/BFL");
+}
+
+CrossValidationResult Verifier::crossValidate(const FinalGraph &finalGraph, const CrossValidationConfig &config) {
+    if (config.engines.empty()) {
+        throw std::runtime_error("No engine to cross validate");
+    }
+    ReductionGraph graph(finalGraph.view());
+    std::uint64_t numberOfNodes = graph.numberOfNodes();
+    std::uint64_t numberOfEdges = graph.numberOfEdges();
+    std::vector<std::uint64_t> sortedNodes = oracleTopoSort(graph);
+    std::vector<std::uint32_t> topoRanks(numberOfNodes);
+    for (std::uint64_t rank = 0; rank < numberOfNodes; ++rank) {
+        topoRanks[sortedNodes[rank]] = rank;
+    }
+    unsigned numberOfThreads = resolveThreadCount(config.numberOfThreads);
+    std::vector<SearchState> states(numberOfThreads);
+
+    CrossValidationResult result;
+    result.numberOfEdges = numberOfEdges;
+    auto report = [&](const std::string &engine, const std::string &reference, std::uint64_t edge, bool isRedundant) {
+        result.numberOfMismatches++;
+        if (result.mismatches.size() < config.maxReportedMismatches) {
+            EdgeMismatch &mismatch = result.mismatches.emplace_back();
+            mismatch.engine = engine;
+            mismatch.reference = reference;
+            mismatch.edgeId = finalGraph.edgeIds[edge];
+            mismatch.startNodeId = graph.nodeId(graph.edgeStart(edge));
+            mismatch.endNodeId = graph.nodeId(graph.edgeEnd(edge));
+            mismatch.isRedundant = isRedundant;
+            searchPath(graph, topoRanks, states[0], graph.edgeStart(edge), graph.edgeEnd(edge), edge, false,
+                       &mismatch.witness);
+        }
+    };
+
+    // every engine runs once, the others are compared with the first one a word of 64 edges at a time
+    auto runEngine = [&](const ReductionOptions &engine, ReductionWorkspace &workspace) {
+        ReductionOptions options = engine;
+        options.numberOfThreads = config.numberOfThreads;
+        TransitiveReducer(options).reduce(graph, workspace);
+        return workspace.redundancyBitmap();
+    };
+    std::string referenceName = engineName(config.engines[0]);
+    ReductionWorkspace referenceWorkspace;
+    std::vector<std::uint64_t> referenceBitmap = runEngine(config.engines[0], referenceWorkspace);
+    result.numberOfRedundantEdges = referenceWorkspace.countRedundantEdges();
+    ReductionWorkspace workspace;
+    for (std::size_t i = 1; i < config.engines.size(); ++i) {
+        std::vector<std::uint64_t> bitmap = runEngine(config.engines[i], workspace);
+        if (countDifferences(referenceBitmap, bitmap) == 0) {
+            continue;
+        }
+        for (std::uint64_t word = 0; word < bitmap.size(); ++word) {
+            for (std::uint64_t bits = referenceBitmap[word] ^ bitmap[word]; bits != 0; bits &= bits - 1) {
+                std::uint64_t edge = word * 64 + std::countr_zero(bits);
+                report(engineName(config.engines[i]), referenceName, edge, workspace.isRedundant[edge]);
+            }
+        }
+    }
+
+    // the oracle checks the reference engine, every edge against the closure if it fits, sampled edges otherwise
+    const std::vector<std::uint8_t> &isRedundant = referenceWorkspace.isRedundant;
+    std::vector<std::uint8_t> contradictions(numberOfEdges, 0);
+    std::uint64_t words = (numberOfNodes + 63) / 64;
+    if (numberOfNodes * words * sizeof(std::uint64_t) <= config.maxClosureBytes) {
+        std::vector<std::uint64_t> closure = buildClosure(graph, sortedNodes, words, numberOfThreads);
+        std::vector<std::vector<std::uint64_t>> covers(numberOfThreads, std::vector<std::uint64_t>(words));
+        runParallel(numberOfNodes, numberOfThreads, [&](std::uint64_t node, unsigned worker) {
+            // the nodes reachable from node over two or more edges
+            std::vector<std::uint64_t> &cover = covers[worker];
+            std::fill(cover.begin(), cover.end(), 0);
+            for (std::uint64_t edge: graph.outgoingEdges(node)) {
+                BitKernels::orInto(cover.data(), closure.data() + graph.edgeEnd(edge) * words, words);
+            }
+            for (std::uint64_t edge: graph.outgoingEdges(node)) {
+                std::uint64_t endNode = graph.edgeEnd(edge);
+                bool isImplied = (cover[endNode / 64] >> (endNode % 64)) & 1;
+                contradictions[edge] = contradictsOracle(graph, isRedundant, edge, isImplied);
+            }
+        });
+        result.oracleCheckedEdges = numberOfEdges;
+        result.isOracleExhaustive = true;
+    } else {
+        std::vector<std::uint64_t> sampledEdges;
+        if (config.numberOfSamples >= numberOfEdges) {
+            sampledEdges.resize(numberOfEdges);
+            std::iota(sampledEdges.begin(), sampledEdges.end(), 0);
+        } else {
+            std::mt19937_64 generator(config.seed);
+            std::uniform_int_distribution<std::uint64_t> distribution(0, numberOfEdges - 1);
+            for (std::uint64_t i = 0; i < config.numberOfSamples; ++i) {
+                sampledEdges.push_back(distribution(generator));
+            }
+            std::sort(sampledEdges.begin(), sampledEdges.end());
+            sampledEdges.erase(std::unique(sampledEdges.begin(), sampledEdges.end()), sampledEdges.end());
+        }
+        runParallel(sampledEdges.size(), numberOfThreads, [&](std::uint64_t i, unsigned worker) {
+            std::uint64_t edge = sampledEdges[i];
+            bool isImplied = searchPath(graph, topoRanks, states[worker], graph.edgeStart(edge), graph.edgeEnd(edge),
+                                        edge, true, nullptr) == SearchResult::Found;
+            contradictions[edge] = contradictsOracle(graph, isRedundant, edge, isImplied);
+        });
+        result.oracleCheckedEdges = sampledEdges.size();
+        result.isOracleExhaustive = sampledEdges.size() == numberOfEdges;
+    }
+    for (std::uint64_t edge = 0; edge < numberOfEdges; ++edge) {
+        if (contradictions[edge]) {
+            report(referenceName, "oracle", edge, isRedundant[edge]);
+        }
+    }
+    return result;
+}
+
+/**
+ * an edge whose reachability certifyReduction checks, with the nodes as indices of the reduced graph
+ */
+struct CertificateQuery {
+    std::uint64_t startNode;
+    std::uint64_t endNode;
+    // the edge in the input graph, and the edge in the reduced graph or noEdge if it was removed
+    std::uint64_t inputEdge;
+    std::uint64_t reducedEdge;
+};
+
+/**
+ * record a violation of the certificate, with its edge while fewer than config.maxReportedViolations are
+ */
+static void reportViolation(ReductionCertificate &certificate, const CertificateConfig &config,
+                            CertificateViolationKind kind, const FinalEdge &edge) {
+    if (certificate.violations.size() < config.maxReportedViolations) {
+        certificate.violations.push_back({kind, edge.id, edge.startNodeId, edge.endNodeId});
+    }
+}
+
+/**
+ * check that the end node of every removed edge among the queries queryAt(i), i < numberOfQueries, is reachable
+ * from its start node in the reduced graph of index, and that of every kept edge is not over other edges, and
+ * count and report the edges that violate this in certificate
+ */
+template<typename Index, typename QueryAt>
+static void checkQueries(FinalGraphView input, const ReducedGraphIndex<Index> &index, std::uint64_t numberOfQueries,
+                         const QueryAt &queryAt, const CertificateConfig &config,
+                         ReductionCertificate &certificate) {
+    const BasicReductionGraph<Index> &graph = index.graph;
+    const std::vector<std::uint64_t> &sortedNodes = index.sortedNodes;
+    const std::vector<Index> &topoRanks = index.topoRanks;
+    std::uint64_t numberOfNodes = graph.numberOfNodes();
+
+    // the target nodes are split into chunks of consecutive topological ranks. Nodes after a chunk cannot reach
+    // it, so a chunk only computes the reachable targets of the nodes before its end, in reverse topological
+    // order, with one row of words bits per node
+    unsigned numberOfThreads = resolveThreadCount(config.numberOfThreads);
+    std::uint64_t words = std::clamp<std::uint64_t>(
+            config.maxMemoryBytes / (std::uint64_t(numberOfThreads) * std::max<std::uint64_t>(numberOfNodes, 1) * 8),
+            1, std::max<std::uint64_t>((numberOfNodes + 63) / 64, 1));
+    std::uint64_t chunkNodes = words * 64;
+    std::uint64_t numberOfChunks = (numberOfNodes + chunkNodes - 1) / chunkNodes;
+
+    // a kept edge is redundant if it has a parallel edge or its end node is reachable over another successor
+    auto hasParallelEdge = [&](const CertificateQuery &query) {
+        return !Verifier::keepsOneParallelEdge(graph, query.startNode, query.endNode);
+    };
+    // the labels settle most edges after a few steps of a search, the chunks only check the rest
+    std::vector<std::uint8_t> isViolated(numberOfQueries, 0);
+    std::vector<std::uint8_t> isPending(numberOfQueries, 1);
+    std::vector<SearchState> states(numberOfThreads);
+    runParallel(numberOfQueries, numberOfThreads, [&](std::uint64_t i, unsigned worker) {
+        CertificateQuery query = queryAt(i);
+        bool isKept = query.reducedEdge != noEdge;
+        if (isKept && graph.outDegree(query.startNode) == 1) {
+            // the only edge of its start node
+            isPending[i] = 0;
+            return;
+        }
+        SearchResult found = searchPath(graph, topoRanks, states[worker], query.startNode, query.endNode,
+                                        query.reducedEdge, isKept, nullptr, config.maxSearchNodes, &index);
+        if (found != SearchResult::Abandoned) {
+            isPending[i] = 0;
+            isViolated[i] = isKept ? found == SearchResult::Found || hasParallelEdge(query)
+                                   : found == SearchResult::NotFound;
+        }
+    });
+    std::vector<std::uint64_t> chunkOffsets(numberOfChunks + 1, 0);
+    for (std::uint64_t i = 0; i < numberOfQueries; ++i) {
+        if (isPending[i]) {
+            chunkOffsets[topoRanks[queryAt(i).endNode] / chunkNodes + 1]++;
+        }
+    }
+    for (std::uint64_t chunk = 0; chunk < numberOfChunks; ++chunk) {
+        chunkOffsets[chunk + 1] += chunkOffsets[chunk];
+    }
+    std::vector<std::uint64_t> chunkQueries(chunkOffsets.back());
+    std::vector<std::uint64_t> positions(chunkOffsets.begin(), chunkOffsets.end() - 1);
+    for (std::uint64_t i = 0; i < numberOfQueries; ++i) {
+        if (isPending[i]) {
+            chunkQueries[positions[topoRanks[queryAt(i).endNode] / chunkNodes]++] = i;
+        }
+    }
+
+    std::vector<std::vector<std::uint64_t>> rows(numberOfThreads);
+    std::vector<std::vector<std::uint8_t>> emptyRows(numberOfThreads);
+    runParallel(numberOfChunks, numberOfThreads, [&](std::uint64_t chunk, unsigned worker) {
+        if (chunkOffsets[chunk] == chunkOffsets[chunk + 1]) {
+            return;
+        }
+        std::uint64_t firstRank = chunk * chunkNodes;
+        std::uint64_t lastRank = std::min(firstRank + chunkNodes, numberOfNodes);
+        // the row of the node of rank r is reachable[r * words, (r + 1) * words), bit t for rank firstRank + t.
+        // In sparse graphs most nodes reach no node of the chunk, their rows are neither cleared nor merged
+        std::vector<std::uint64_t> &reachable = rows[worker];
+        std::vector<std::uint8_t> &isRowEmpty = emptyRows[worker];
+        reachable.resize(lastRank * words);
+        isRowEmpty.resize(lastRank);
+        for (std::uint64_t rank = lastRank; rank-- > 0;) {
+            std::uint64_t* row = reachable.data() + rank * words;
+            isRowEmpty[rank] = 1;
+            for (std::uint64_t edge: graph.outgoingEdges(sortedNodes[rank])) {
+                std::uint64_t endRank = topoRanks[graph.edgeEnd(edge)];
+                if (endRank >= lastRank || (endRank < firstRank && isRowEmpty[endRank])) {
+                    continue;
+                }
+                if (isRowEmpty[rank]) {
+                    std::fill(row, row + words, 0);
+                    isRowEmpty[rank] = 0;
+                }
+                if (!isRowEmpty[endRank]) {
+                    BitKernels::orInto(row, reachable.data() + endRank * words, words);
+                }
+                if (endRank >= firstRank) {
+                    row[(endRank - firstRank) / 64] |= std::uint64_t(1) << ((endRank - firstRank) % 64);
+                }
+            }
+        }
+        auto isReachable = [&](std::uint64_t node, std::uint64_t target) {
+            if (topoRanks[node] >= topoRanks[target] || isRowEmpty[topoRanks[node]]) {
+                return false;
+            }
+            std::uint64_t bit = topoRanks[target] - firstRank;
+            return ((reachable[topoRanks[node] * words + bit / 64] >> (bit % 64)) & 1) != 0;
+        };
+        for (std::uint64_t i = chunkOffsets[chunk]; i < chunkOffsets[chunk + 1]; ++i) {
+            CertificateQuery query = queryAt(chunkQueries[i]);
+            if (query.reducedEdge == noEdge) {
+                isViolated[chunkQueries[i]] = !isReachable(query.startNode, query.endNode);
+                continue;
+            }
+            bool isImplied = hasParallelEdge(query);
+            for (std::uint64_t edge: graph.outgoingEdges(query.startNode)) {
+                std::uint64_t endNode = graph.edgeEnd(edge);
+                isImplied = isImplied || (endNode != query.endNode && isReachable(endNode, query.endNode));
+            }
+            isViolated[chunkQueries[i]] = isImplied;
+        }
+    });
+
+    for (std::uint64_t i = 0; i < numberOfQueries; ++i) {
+        if (isViolated[i]) {
+            CertificateQuery query = queryAt(i);
+            bool isKept = query.reducedEdge != noEdge;
+            CertificateViolationKind kind = isKept ? CertificateViolationKind::RedundantEdge
+                                                   : CertificateViolationKind::LostReachability;
+            (isKept ? certificate.redundantEdges : certificate.lostReachabilityEdges)++;
+            reportViolation(certificate, config, kind, input.edge(query.inputEdge));
+        }
+    }
+}
+
+ReductionCertificate Verifier::certifyReduction(const FinalGraph &input, const FinalGraph &reduced,
+                                                const CertificateConfig &config) {
+    ReductionGraph graph(reduced.view());
+    std::uint64_t numberOfNodes = graph.numberOfNodes();
+    std::unordered_map<std::uint64_t, std::uint64_t> nodeIndices;
+    for (std::uint64_t node = 0; node < numberOfNodes; ++node) {
+        nodeIndices.emplace(graph.nodeId(node), node);
+    }
+    if (input.numberOfNodes() != numberOfNodes
+        || !std::all_of(input.nodeIds.begin(), input.nodeIds.end(), [&](std::uint64_t id) {
+            return nodeIndices.contains(id);
+        })) {
+        throw std::runtime_error("The reduced graph does not have the nodes of the input graph");
+    }
+    ReducedGraphIndex<std::uint32_t> index = indexReducedGraph(graph, oracleTopoSort(graph));
+
+    ReductionCertificate certificate;
+    certificate.numberOfEdges = input.numberOfEdges();
+    // match the reduced edges with the input edges by id
+    std::unordered_map<std::uint64_t, std::uint64_t> inputEdges;
+    for (std::uint64_t edge = 0; edge < input.numberOfEdges(); ++edge) {
+        inputEdges.emplace(input.edgeIds[edge], edge);
+    }
+    std::vector<std::uint8_t> isKept(input.numberOfEdges(), 0);
+    std::vector<CertificateQuery> queries;
+    queries.reserve(input.numberOfEdges());
+    for (std::uint64_t edge = 0; edge < graph.numberOfEdges(); ++edge) {
+        auto found = inputEdges.find(reduced.edgeIds[edge]);
+        if (found == inputEdges.end() || isKept[found->second]
+            || input.edgeStartNodeIds[found->second] != reduced.edgeStartNodeIds[edge]
+            || input.edgeEndNodeIds[found->second] != reduced.edgeEndNodeIds[edge]) {
+            certificate.unknownEdges++;
+            reportViolation(certificate, config, CertificateViolationKind::UnknownEdge, reduced.view().edge(edge));
+            continue;
+        }
+        isKept[found->second] = 1;
+        queries.push_back({graph.edgeStart(edge), graph.edgeEnd(edge), found->second, edge});
+    }
+    for (std::uint64_t edge = 0; edge < input.numberOfEdges(); ++edge) {
+        if (!isKept[edge]) {
+            certificate.numberOfRemovedEdges++;
+            queries.push_back({nodeIndices.at(input.edgeStartNodeIds[edge]), nodeIndices.at(input.edgeEndNodeIds[edge]),
+                               edge, noEdge});
+        }
+    }
+    checkQueries(input.view(), index, queries.size(), [&queries](std::uint64_t i) {
+        return queries[i];
+    }, config, certificate);
+    return certificate;
+}
+
+template<typename Index>
+ReductionCertificate Verifier::certifyReduction(FinalGraphView input, const BasicReductionGraph<Index> &graph,
+                                                const BasicReductionWorkspace<Index> &workspace,
+                                                const CertificateConfig &config) {
+    if (!workspace.fits(graph) || input.numberOfEdges() != graph.numberOfEdges()) {
+        throw std::runtime_error("The workspace does not hold a reduction of the graph");
+    }
+    BasicReductionGraph<Index> reducedGraph(graph, workspace.isRedundant);
+    // TRO+ sorted the graph, a BFL traversal finishes every node after the nodes it reaches, and an order of the
+    // graph also orders its subgraph
+    std::vector<std::uint64_t> sortedNodes;
+    if (workspace.hasSchedule(graph)) {
+        sortedNodes.assign(workspace.topoSortedNodes.begin(), workspace.topoSortedNodes.end());
+    } else if (workspace.hasBFL()) {
+        sortedNodes.assign(workspace.postOrder.rbegin(), workspace.postOrder.rend());
+    } else {
+        sortedNodes = oracleTopoSort(reducedGraph);
+    }
+    ReducedGraphIndex<Index> index = indexReducedGraph(reducedGraph, std::move(sortedNodes));
+
+    // edge r of reducedGraph is edge keptEdges[r] of graph. The queries are the edges of reducedGraph by start
+    // node, so that the searches from one node share its successors in cache, then the removed edges
+    std::vector<Index> keptEdges;
+    std::vector<Index> queryEdges;
+    keptEdges.reserve(reducedGraph.numberOfEdges());
+    queryEdges.reserve(graph.numberOfEdges());
+    for (std::uint64_t edge = 0; edge < graph.numberOfEdges(); ++edge) {
+        if (!workspace.isRedundant[edge]) {
+            keptEdges.push_back(edge);
+        }
+    }
+    for (std::uint64_t node = 0; node < reducedGraph.numberOfNodes(); ++node) {
+        queryEdges.insert(queryEdges.end(), reducedGraph.outgoingEdges(node).begin(),
+                          reducedGraph.outgoingEdges(node).end());
+    }
+    for (std::uint64_t edge = 0; edge < graph.numberOfEdges(); ++edge) {
+        if (workspace.isRedundant[edge]) {
+            queryEdges.push_back(edge);
+        }
+    }
+    ReductionCertificate certificate;
+    certificate.numberOfEdges = graph.numberOfEdges();
+    certificate.numberOfRemovedEdges = graph.numberOfEdges() - reducedGraph.numberOfEdges();
+    checkQueries(input, index, queryEdges.size(), [&](std::uint64_t i) {
+        std::uint64_t edge = queryEdges[i];
+        return i < reducedGraph.numberOfEdges()
+               ? CertificateQuery{reducedGraph.edgeStart(edge), reducedGraph.edgeEnd(edge), keptEdges[edge], edge}
+               : CertificateQuery{graph.edgeStart(edge), graph.edgeEnd(edge), edge, noEdge};
+    }, config, certificate);
+    return certificate;
+}
+
+template ReductionCertificate Verifier::certifyReduction(FinalGraphView, const ReductionGraph &,
+                                                         const ReductionWorkspace &, const CertificateConfig &);
+template ReductionCertificate Verifier::certifyReduction(FinalGraphView, const WideReductionGraph &,
+                                                         const WideReductionWorkspace &, const CertificateConfig &);
+
+FinalGraph Verifier::reducedGraph(const FinalGraph &input, const std::vector<std::uint8_t> &isRedundant) {
+    FinalGraph reduced;
+    reduced.reserve(input.numberOfNodes(),
+                    input.numberOfEdges() - std::count(isRedundant.begin(), isRedundant.end(), std::uint8_t(1)));
+    reduced.nodeIds = input.nodeIds;
+    for (std::uint64_t edge = 0; edge < input.numberOfEdges(); ++edge) {
+        if (!isRedundant[edge]) {
+            reduced.addEdge(input.view().edge(edge));
+        }
+    }
+    return reduced;
+}
+
+bool Verifier::crossCheckTRCorrectness(std::string filePath) {
+    return crossValidate(GraphParser::importFinalGraph(filePath, GraphParser::detectGraphFileFormat(filePath)), {})
+            .isValid();
+}
+
+bool Verifier::verifyGraphTopoOrder(std::string fileName, unsigned numberOfThreads) {
+    FinalGraph finalGraph = GraphParser::importFinalGraph(fileName, GraphParser::detectGraphFileFormat(fileName));
+    ReductionGraph graph(finalGraph.view());
+    ReductionWorkspace workspace;
+    workspace.reset(graph);
+    TransitiveReducer().topoSort(graph, workspace);
+    return TransitiveReducer::isTopologicalOrder(graph, workspace.topoOrder, numberOfThreads);
 }
 
 bool Verifier::verifyEdgesSortingOrder(std::string filePath) {
-    FinalGraph* graph = GraphParser::importFinalGraph(filePath);
-    IntermediateGraph* intermediateGraph = GraphParser::parseToIntermediateGraph(graph);
+    std::unique_ptr<IntermediateGraph> intermediateGraph =
+            GraphParser::parseToIntermediateGraph(
+                    GraphParser::importFinalGraph(filePath, GraphParser::detectGraphFileFormat(filePath)));
 
+    intermediateGraph->constructBFLRI();
     intermediateGraph->markRedundantEdges_TROPlus(true);
     std::vector<std::pair<IntermediateEdge*, bool>> &sortedEdgePairs = intermediateGraph->sortedEdgePairs;
     for (int i = 0; i < static_cast<long long int>(intermediateGraph->sortedEdgePairs.size()) - 1; ++i) {
@@ -47,8 +757,8 @@ bool Verifier::verifyEdgesSortingOrder(std::string filePath) {
         if (sortedEdgePairs[i].second && sortedEdgePairs[i + 1].second) {
             //when both edges have the same end node
             if (sortedEdgePairs[i].first->endNode == sortedEdgePairs[i + 1].first->endNode) {
-                //when both edges are not sorted by descending topo-order
-                if (sortedEdgePairs[i].first->startNode->topoOrder <=
+                //when both edges are not sorted by descending topo-order, parallel edges share it
+                if (sortedEdgePairs[i].first->startNode->topoOrder <
                     sortedEdgePairs[i + 1].first->startNode->topoOrder)
                     return false;
             }
@@ -65,8 +775,8 @@ bool Verifier::verifyEdgesSortingOrder(std::string filePath) {
         else if (!sortedEdgePairs[i].second && !sortedEdgePairs[i + 1].second) {
             //when both edges have the same measureGraphTRTime node
             if (sortedEdgePairs[i].first->startNode == sortedEdgePairs[i + 1].first->startNode) {
-                //when both edges are not sorted by ascending topo-order
-                if (sortedEdgePairs[i].first->endNode->topoOrder >= sortedEdgePairs[i + 1].first->endNode->topoOrder)
+                //when both edges are not sorted by ascending topo-order, parallel edges share it
+                if (sortedEdgePairs[i].first->endNode->topoOrder > sortedEdgePairs[i + 1].first->endNode->topoOrder)
                     return false;
             }
                 //when both edges have different measureGraphTRTime nodes
@@ -92,3 +802,36 @@ bool Verifier::verifyEdgesSortingOrder(std::string filePath) {
     }
     return true;
 }
+
+MemoryStabilityResult Verifier::checkMemoryStability(const std::string &filePath, unsigned iterations) {
+    std::filesystem::path scratchPath = std::filesystem::temp_directory_path() / "algorithm_project_memory_check";
+    std::string reducedPath = scratchPath.string() + ".txt";
+    std::string binaryPath = scratchPath.string() + ".bin";
+    GraphFileFormat format = GraphParser::detectGraphFileFormat(filePath);
+
+    MemoryStabilityResult result;
+    result.iterations = std::max(iterations, 2u);
+    unsigned warmupIterations = std::max(1u, result.iterations / 10);
+    for (unsigned i = 0; i < result.iterations; ++i) {
+        {
+            // the whole import, reduce, export and convert pipeline, every object released at the end of the scope
+            std::unique_ptr<IntermediateGraph> intermediateGraph =
+                    GraphParser::parseToIntermediateGraph(GraphParser::importFinalGraph(filePath, format));
+            intermediateGraph->constructDFSRI();
+            intermediateGraph->markRedundantEdges_DFS();
+            intermediateGraph->constructBFLRI();
+            intermediateGraph->markRedundantEdges_TROPlus(true);
+            GraphParser::exportReducedGraph(intermediateGraph.get(), ReductionAlgorithm::TROPlus, reducedPath,
+                                            GraphFileFormat::Text);
+            GraphParser::exportFinalGraphBinary(GraphParser::parseToFinalGraph(intermediateGraph.get()), binaryPath);
+            FinalGraph converted = GraphParser::importFinalGraphBinary(binaryPath);
+        }
+        if (i + 1 == warmupIterations) {
+            result.rssAfterWarmupKilobytes = PhaseProfiler::currentRss();
+        }
+    }
+    result.rssAtEndKilobytes = PhaseProfiler::currentRss();
+    std::filesystem::remove(reducedPath);
+    std::filesystem::remove(binaryPath);
+    return result;
+}
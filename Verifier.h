@@ -7,29 +7,216 @@
 #define ALGORITHMPROJECT_VERIFIER_H
 
 
+#include <cstdint>
+#include <string>
+#include <vector>
 #include "IntermediateGraph.h"
+#include "TransitiveReducer.h"
+
+/**
+ * @brief settings of Verifier::crossValidate
+ */
+struct CrossValidationConfig {
+    // engines to run, each once. The first is the reference the others and the oracle are compared with
+    std::vector<ReductionOptions> engines = defaultEngines();
+    // threads of the engines and of the oracle, 0 for all hardware threads
+    unsigned numberOfThreads = 0;
+    // mismatching edges reported with witnesses, all of them are counted
+    std::uint64_t maxReportedMismatches = 10;
+    // the oracle checks every edge against the full reachability closure if it fits into this many bytes,
+    // otherwise numberOfSamples random edges by graph search
+    std::uint64_t maxClosureBytes = std::uint64_t(256) << 20;
+    std::uint64_t numberOfSamples = 10000;
+    std::uint64_t seed = 1;
+
+    /**
+     * @brief both algorithms with both indices
+     */
+    static std::vector<ReductionOptions> defaultEngines();
+};
+
+/**
+ * @brief an edge on which an engine disagrees with the reference engine or the oracle
+ */
+struct EdgeMismatch {
+    // the engine and what it was compared with, "oracle" for the closure oracle
+    std::string engine;
+    std::string reference;
+    std::uint64_t edgeId = 0;
+    std::uint64_t startNodeId = 0;
+    std::uint64_t endNodeId = 0;
+    // whether engine removed the edge
+    bool isRedundant = false;
+    // node ids of a path from the start to the end node that does not use the edge, empty if there is none
+    std::vector<std::uint64_t> witness;
+};
+
+/**
+ * @brief result of Verifier::crossValidate
+ */
+struct CrossValidationResult {
+    std::uint64_t numberOfEdges = 0;
+    std::uint64_t numberOfRedundantEdges = 0;
+    // edges the oracle checked, and whether that was all of them against the full closure
+    std::uint64_t oracleCheckedEdges = 0;
+    bool isOracleExhaustive = false;
+    // mismatching edges over all comparisons, and the first of them with witnesses
+    std::uint64_t numberOfMismatches = 0;
+    std::vector<EdgeMismatch> mismatches;
+
+    bool isValid() const {
+        return numberOfMismatches == 0;
+    }
+};
+
+/**
+ * @brief settings of Verifier::certifyReduction
+ */
+struct CertificateConfig {
+    // threads checking chunks of target nodes, 0 for all hardware threads
+    unsigned numberOfThreads = 0;
+    // memory of the reachability bits of all threads together
+    std::uint64_t maxMemoryBytes = std::uint64_t(64) << 20;
+    // edges are first checked by a search pruned by interval labels that gives up after visiting this many nodes,
+    // only the rest by the chunks
+    std::uint64_t maxSearchNodes = 4096;
+    // violations reported with their edge, all of them are counted
+    std::uint64_t maxReportedViolations = 10;
+};
+
+enum class CertificateViolationKind {
+    // an edge of the reduced graph that is not in the input graph, or not between the same nodes
+    UnknownEdge,
+    // an edge removed from the input graph whose end node is not reachable from its start node in the reduced graph
+    LostReachability,
+    // an edge of the reduced graph whose end node is also reachable from its start node over other edges
+    RedundantEdge
+};
+
+struct CertificateViolation {
+    CertificateViolationKind kind = CertificateViolationKind::UnknownEdge;
+    std::uint64_t edgeId = 0;
+    std::uint64_t startNodeId = 0;
+    std::uint64_t endNodeId = 0;
+};
+
+/**
+ * @brief result of Verifier::certifyReduction. Without violations the reduced graph is a subgraph with the same
+ * reachability as the input and without redundant edges, which makes it the transitive reduction.
+ */
+struct ReductionCertificate {
+    std::uint64_t numberOfEdges = 0;
+    std::uint64_t numberOfRemovedEdges = 0;
+    std::uint64_t unknownEdges = 0;
+    std::uint64_t lostReachabilityEdges = 0;
+    std::uint64_t redundantEdges = 0;
+    std::vector<CertificateViolation> violations;
+
+    std::uint64_t numberOfViolations() const {
+        return unknownEdges + lostReachabilityEdges + redundantEdges;
+    }
+
+    bool isValid() const {
+        return numberOfViolations() == 0;
+    }
+};
+
+/**
+ * @brief RSS before and after repeating the import, reduce and export pipeline on one graph
+ */
+struct MemoryStabilityResult {
+    // RSS growth allowed between the end of the warmup and the last iteration, for allocator caches
+    static constexpr std::int64_t toleranceKilobytes = 4096;
+
+    unsigned iterations = 0;
+    std::int64_t rssAfterWarmupKilobytes = 0;
+    std::int64_t rssAtEndKilobytes = 0;
+
+    std::int64_t growthKilobytes() const {
+        return rssAtEndKilobytes - rssAfterWarmupKilobytes;
+    }
+
+    bool isStable() const {
+        return growthKilobytes() <= toleranceKilobytes;
+    }
+};
 
 class Verifier {
 public:
     /**
-     * @brief cross check the correctness of two different transitive reduction algorithms by comparing their result
+     * @brief cross check the correctness of both transitive reduction algorithms with both indices and the closure
+     * oracle, see crossValidate
      */
     static bool crossCheckTRCorrectness(std::string fileName);
 
     /**
-     * @brief verify whether topological order of the given graph is correct
+     * @brief run every configured engine once on the graph and compare their redundancy bitmaps with the first
+     * engine, then check the first engine against a closure oracle that shares no code with the engines. An edge
+     * (u, v) must be redundant exactly if v is reachable from u over a path of two or more edges, and parallel
+     * edges that are not must follow keepsOneParallelEdge. Throws std::runtime_error if the graph contains a cycle.
      */
-    static bool verifyGraphTopoOrder(std::string fileName);
+    static CrossValidationResult crossValidate(const FinalGraph &finalGraph, const CrossValidationConfig &config);
 
     /**
-     * @brief a recursive helper for function verifyGraphTopoOrder
+     * @brief check that reduced is the transitive reduction of input: every reduced edge is an input edge with the
+     * same id and nodes, every removed edge is implied by a path in reduced, and no reduced edge is implied by the
+     * others, which includes parallel edges by keepsOneParallelEdge. Each edge is first checked by a bounded search
+     * in reduced, pruned by interval labels of one depth first traversal of it, and the edges the searches give up
+     * on by reachability computed for chunks of target nodes at a time, in parallel and within
+     * config.maxMemoryBytes. Throws std::runtime_error if the graphs do not have the same nodes or reduced contains
+     * a cycle.
      */
-    static bool verifyNodeTopoOrder(IntermediateNode* node);
+    static ReductionCertificate certifyReduction(const FinalGraph &input, const FinalGraph &reduced,
+                                                 const CertificateConfig &config);
+
+    /**
+     * @brief certifyReduction of the reduction the engine left in workspace for graph, which was built from input.
+     * The reduced graph is taken from graph without mapping node and edge ids again, and the topological order the
+     * engine computed is checked against every kept edge and used instead of a new sort. Instantiated for
+     * ReductionGraph and WideReductionGraph.
+     */
+    template<typename Index>
+    static ReductionCertificate certifyReduction(FinalGraphView input, const BasicReductionGraph<Index> &graph,
+                                                 const BasicReductionWorkspace<Index> &workspace,
+                                                 const CertificateConfig &config);
+
+    /**
+     * @brief the parallel edge rule of crossValidate and certifyReduction: of the copies of an edge (u, v) whose end
+     * node is not reachable from u over two or more edges, exactly one remains. The engines all keep the last copy
+     * in input order, so crossValidate finds them equal. Returns whether the copies of (startNode, endNode) in graph
+     * meet the rule once the edges marked in isRedundant are removed, an empty isRedundant removes none.
+     * Instantiated for ReductionGraph and WideReductionGraph.
+     */
+    template<typename Index>
+    static bool keepsOneParallelEdge(const BasicReductionGraph<Index> &graph, std::uint64_t startNode,
+                                     std::uint64_t endNode, const std::vector<std::uint8_t> &isRedundant = {});
+
+    /**
+     * @brief the graph with all nodes of input and its edges that are not redundant, for certifyReduction
+     */
+    static FinalGraph reducedGraph(const FinalGraph &input, const std::vector<std::uint8_t> &isRedundant);
+
+    /**
+     * @brief the name of an engine in reports, e.g. "TRO+/BFL"
+     */
+    static std::string engineName(const ReductionOptions &options);
+
+    /**
+     * @brief verify whether topological order of the given graph is correct, in one pass over its edges
+     */
+    static bool verifyGraphTopoOrder(std::string fileName, unsigned numberOfThreads = 1);
 
     /**
      * @brief verify whether edges in TRO_Plus algorithm is sorted correctly before starting redundancy check
      */
     static bool verifyEdgesSortingOrder(std::string fileName);
+
+    /**
+     * @brief memory regression check: import, reduce with both algorithms, export the reduction and convert the
+     * graph to the binary format and back the given number of times, and compare the RSS after the first tenth
+     * of the iterations with the RSS at the end. A pipeline that leaks grows with every iteration.
+     */
+    static MemoryStabilityResult checkMemoryStability(const std::string &filePath, unsigned iterations);
 };
 
 
@@ -1,4 +1,644 @@
+//
+// command line driver: reduce, benchmark, verify, fuzz and convert graph files
+//
 
-int main() {
-    return 0;
+#include "BatchExecutor.h"
+#include "BitKernels.h"
+#include "DifferentialTester.h"
+#include "ExternalReducer.h"
+#include "GraphParser.h"
+#include "GraphReorderer.h"
+#include "TimeMeasurer.h"
+#include "TransitiveReducer.h"
+#include "Verifier.h"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <glob.h>
+#include <iostream>
+#include <map>
+#include <optional>
+#include <set>
+#include <string>
+#include <vector>
+
+/**
+ * exit status of the driver, so that batch pipelines can tell bad invocations from failed runs
+ */
+enum ExitCode {
+    Success = 0,
+    // the input could not be read or processed
+    Failure = 1,
+    // unknown subcommand, option or option value
+    UsageError = 2,
+    // verify or fuzz found a check that does not hold, or perf a regression
+    VerificationFailed = 3
+};
+
+/**
+ * an invalid command line, reported with the usage text
+ */
+class UsageException : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+/**
+ * positional arguments and "--name value" options of a subcommand. Flags are options without a value.
+ */
+struct Arguments {
+    std::vector<std::string> positional;
+    std::map<std::string, std::string> options;
+    std::set<std::string> flags;
+
+    bool has(const std::string &name) const {
+        return options.contains(name);
+    }
+
+    std::string get(const std::string &name, const std::string &fallback) const {
+        auto found = options.find(name);
+        return found == options.end() ? fallback : found->second;
+    }
+};
+
+static void printUsage() {
+    std::cerr << "usage: AlgorithmProject <command> [options]\n"
+                 "\n"
+                 "  reduce <input> [--format auto|text|binary] [--algorithm dfs|tro+|external]\n"
+                 "         [--index dfs_ri|bfl] [--threads <t>] [--output <file>] [--output-format text|binary]\n"
+                 "         [--compression none|zstd|lz4] [--bitmap <file>] [--memory <MiB>] [--work-dir <dir>]\n"
+                 "         [--order input|topological|dfs|rcm] [--certify]\n"
+                 "  bench <file|directory|glob>... [--csv <file>] [--json <file>] [--warmup <n>] [--min-runs <n>]\n"
+                 "         [--max-runs <n>] [--confidence <fraction>] [--max-seconds <s>] [--cpu <c>]\n"
+                 "         [--phase-runs <n>] [--export <file>] [--order input|topological|dfs|rcm] [--no-prefault]\n"
+                 "         [--no-hardware-counters]\n"
+                 "  batch <file|directory|glob>... [--output <file>] [--output-format text|binary]\n"
+                 "         [--algorithm dfs|tro+] [--workers <t>] [--loaders <t>] [--memory <MiB>]\n"
+                 "  verify <input> [--check all|cross|topo|sort|memory|certificate] [--threads <t>]\n"
+                 "         [--samples <n>] [--mismatches <n>] [--iterations <n>] [--reduced <file>]\n"
+                 "  fuzz [--iterations <n>] [--seed <s>] [--max-nodes <n>] [--failure <file>]\n"
+                 "  perf [--csv <file>] [--baseline <file>] [--tolerance <fraction>] [--runs <n>] [--seed <s>]\n"
+                 "       [--kernels scalar|sse4.2|avx2|avx512]\n"
+                 "  convert <input> <output> [--from auto|text|binary] [--to text|binary]\n"
+                 "         [--compression none|zstd|lz4]\n"
+                 "\n"
+                 "exit status: 0 success, 1 failure, 2 usage error, 3 verification failed\n";
+}
+
+/**
+ * split the arguments after the subcommand. Options must be in allowedOptions, flags in allowedFlags.
+ */
+static Arguments parseArguments(int argc, char* argv[], const std::set<std::string> &allowedOptions,
+                                const std::set<std::string> &allowedFlags) {
+    Arguments arguments;
+    for (int i = 2; i < argc; ++i) {
+        std::string argument = argv[i];
+        if (argument.rfind("--", 0) != 0) {
+            arguments.positional.push_back(argument);
+        } else if (allowedFlags.contains(argument)) {
+            arguments.flags.insert(argument);
+        } else if (!allowedOptions.contains(argument)) {
+            throw UsageException("unknown option " + argument);
+        } else if (i + 1 >= argc) {
+            throw UsageException("missing value of " + argument);
+        } else {
+            arguments.options[argument] = argv[++i];
+        }
+    }
+    return arguments;
+}
+
+/**
+ * choose one of the allowed values of an option
+ */
+template<typename T>
+static T parseChoice(const Arguments &arguments, const std::string &name, const std::string &fallback,
+                     const std::map<std::string, T> &choices) {
+    std::string value = arguments.get(name, fallback);
+    auto found = choices.find(value);
+    if (found == choices.end()) {
+        throw UsageException("invalid value of " + name + ": " + value);
+    }
+    return found->second;
+}
+
+static NodeOrdering parseOrdering(const Arguments &arguments) {
+    return parseChoice<NodeOrdering>(arguments, "--order", "input",
+                                     {{"input",       NodeOrdering::Input},
+                                      {"topological", NodeOrdering::Topological},
+                                      {"dfs",         NodeOrdering::DFSPostOrder},
+                                      {"rcm",         NodeOrdering::ReverseCuthillMcKee}});
+}
+
+static std::uint64_t parseNumber(const Arguments &arguments, const std::string &name, std::uint64_t fallback) {
+    if (!arguments.has(name)) {
+        return fallback;
+    }
+    try {
+        std::size_t length;
+        std::string value = arguments.get(name, "");
+        std::uint64_t number = std::stoull(value, &length);
+        if (length != value.size() || value[0] == '-') {
+            throw std::invalid_argument(value);
+        }
+        return number;
+    } catch (const std::logic_error &) {
+        throw UsageException("invalid value of " + name + ": " + arguments.get(name, ""));
+    }
+}
+
+static double parseDecimal(const Arguments &arguments, const std::string &name, double fallback) {
+    if (!arguments.has(name)) {
+        return fallback;
+    }
+    try {
+        return std::stod(arguments.get(name, ""));
+    } catch (const std::logic_error &) {
+        throw UsageException("invalid value of " + name + ": " + arguments.get(name, ""));
+    }
+}
+
+static GraphFileFormat parseInputFormat(const Arguments &arguments, const std::string &name,
+                                        const std::string &filePath) {
+    std::string value = arguments.get(name, "auto");
+    if (value == "auto") {
+        return GraphParser::detectGraphFileFormat(filePath);
+    }
+    return parseChoice<GraphFileFormat>(arguments, name, "auto",
+                                        {{"text",   GraphFileFormat::Text},
+                                         {"binary", GraphFileFormat::Binary}});
+}
+
+static GraphFileFormat parseOutputFormat(const Arguments &arguments, const std::string &name) {
+    return parseChoice<GraphFileFormat>(arguments, name, "text",
+                                        {{"text",   GraphFileFormat::Text},
+                                         {"binary", GraphFileFormat::Binary}});
+}
+
+static OutputCompression parseCompression(const Arguments &arguments) {
+    OutputCompression compression = parseChoice<OutputCompression>(arguments, "--compression", "none",
+                                                                   {{"none", OutputCompression::None},
+                                                                    {"zstd", OutputCompression::Zstd},
+                                                                    {"lz4",  OutputCompression::Lz4}});
+    if (!BufferedWriter::isCompressionAvailable(compression)) {
+        throw UsageException("compression " + arguments.get("--compression", "")
+                             + " is not available in this build");
+    }
+    return compression;
+}
+
+static void requirePositional(const Arguments &arguments, std::size_t count) {
+    if (arguments.positional.size() != count) {
+        throw UsageException("expected " + std::to_string(count) + " file argument(s)");
+    }
+}
+
+/**
+ * print the violations of a reduction certificate, the result is reported by the caller
+ */
+static void printCertificate(const ReductionCertificate &certificate) {
+    std::cout << certificate.numberOfRemovedEdges << " of " << certificate.numberOfEdges << " edges removed\n";
+    for (const CertificateViolation &violation: certificate.violations) {
+        const char* kind = violation.kind == CertificateViolationKind::UnknownEdge ? "is not in the input"
+                           : violation.kind == CertificateViolationKind::LostReachability
+                             ? "was removed but its nodes are no longer connected"
+                             : "is kept but implied by other edges";
+        std::cout << "  edge " << violation.edgeId << " (" << violation.startNodeId << " -> " << violation.endNodeId
+                  << ") " << kind << "\n";
+    }
+    if (certificate.numberOfViolations() > certificate.violations.size()) {
+        std::cout << "  " << certificate.numberOfViolations() - certificate.violations.size() << " more violations\n";
+    }
+}
+
+/**
+ * report the certificate of the output of reduce
+ */
+static int reportCertificate(const ReductionCertificate &certificate,
+                             std::chrono::duration<double, std::milli> elapsed) {
+    printCertificate(certificate);
+    std::cerr << "certified in " << elapsed.count() << " ms\n";
+    std::cout << "reduction certificate: " << (certificate.isValid() ? "passed" : "FAILED") << "\n";
+    return certificate.isValid() ? Success : VerificationFailed;
+}
+
+/**
+ * check the output of reduce with Verifier::certifyReduction
+ */
+static int certifyOutput(const FinalGraph &input, const FinalGraph &reduced, unsigned numberOfThreads) {
+    auto start = std::chrono::steady_clock::now();
+    CertificateConfig config;
+    config.numberOfThreads = numberOfThreads;
+    ReductionCertificate certificate = Verifier::certifyReduction(input, reduced, config);
+    return reportCertificate(certificate, std::chrono::steady_clock::now() - start);
+}
+
+/**
+ * per edge results of the reduction engine, in the edge order of the input graph
+ */
+struct EngineResult {
+    std::vector<std::uint8_t> isRedundant;
+    std::vector<std::uint64_t> redundancyBitmap;
+    std::uint64_t redundantEdges = 0;
+    // with isCertifying, the certificate of the reduction and the time it took
+    std::optional<ReductionCertificate> certificate;
+    std::chrono::duration<double, std::milli> certificationTime{0};
+};
+
+/**
+ * reduce graph with the engine of the given index width, mapping the results back if the graph was reordered.
+ * With isCertifying the reduction is certified on the engine's graph and workspace before they are released.
+ */
+template<typename Index>
+static EngineResult reduceWith(FinalGraphView graph, const ReorderedGraph* reordered, const ReductionOptions &options,
+                               bool isCertifying) {
+    BasicReductionGraph<Index> reductionGraph(graph);
+    BasicReductionWorkspace<Index> workspace;
+    BasicTransitiveReducer<Index>(options).reduce(reductionGraph, workspace);
+    EngineResult result;
+    if (isCertifying) {
+        auto start = std::chrono::steady_clock::now();
+        CertificateConfig config;
+        config.numberOfThreads = options.numberOfThreads;
+        result.certificate = Verifier::certifyReduction(graph, reductionGraph, workspace, config);
+        result.certificationTime = std::chrono::steady_clock::now() - start;
+    }
+    if (reordered) {
+        workspace.isRedundant = reordered->toInputOrder(workspace.isRedundant);
+    }
+    result.redundancyBitmap = workspace.redundancyBitmap();
+    result.redundantEdges = workspace.countRedundantEdges();
+    result.isRedundant = std::move(workspace.isRedundant);
+    return result;
+}
+
+static int runReduce(const Arguments &arguments) {
+    requirePositional(arguments, 1);
+    const std::string &input = arguments.positional[0];
+    std::string algorithm = arguments.get("--algorithm", "tro+");
+    if (algorithm != "dfs" && algorithm != "tro+" && algorithm != "external") {
+        throw UsageException("invalid value of --algorithm: " + algorithm);
+    }
+    std::string defaultIndex = algorithm == "dfs" ? "dfs_ri" : "bfl";
+    ReachabilityIndex index = parseChoice<ReachabilityIndex>(arguments, "--index", defaultIndex,
+                                                             {{"dfs_ri", ReachabilityIndex::DFS_RI},
+                                                              {"bfl",    ReachabilityIndex::BFL}});
+    // DFS_RI construction, the DFS redundancy check and the TRO+ edge schedule run on these threads
+    std::uint64_t numberOfThreads = parseNumber(arguments, "--threads", 1);
+    if (numberOfThreads == 0) {
+        throw UsageException("--threads must be at least 1");
+    }
+    GraphFileFormat outputFormat = parseOutputFormat(arguments, "--output-format");
+    OutputCompression compression = parseCompression(arguments);
+    std::string output = arguments.get("--output", "");
+    NodeOrdering ordering = parseOrdering(arguments);
+    GraphFileFormat inputFormat = parseInputFormat(arguments, "--format", input);
+    auto start = std::chrono::steady_clock::now();
+
+    if (algorithm == "external") {
+        if (arguments.has("--index") || arguments.has("--bitmap") || arguments.has("--order")
+            || outputFormat != GraphFileFormat::Text || compression != OutputCompression::None || output.empty()) {
+            throw UsageException("--algorithm external needs --output and writes an uncompressed txt graph");
+        }
+        ExternalReductionConfig config;
+        config.workDirectory = arguments.get("--work-dir", config.workDirectory);
+        config.memoryBudgetBytes = parseNumber(arguments, "--memory", config.memoryBudgetBytes >> 20) << 20;
+        config.inputFormat = inputFormat;
+        std::uint64_t redundantEdges = ExternalReducer::reduceGraphFile(input, output, config);
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        std::cerr << redundantEdges << " redundant edges removed in " << elapsed.count() << " ms\n";
+        if (arguments.flags.contains("--certify")) {
+            return certifyOutput(GraphParser::importFinalGraph(input, inputFormat),
+                                 GraphParser::importFinalGraph(output),
+                                 static_cast<unsigned>(numberOfThreads));
+        }
+        return Success;
+    }
+    if (arguments.has("--memory") || arguments.has("--work-dir")) {
+        throw UsageException("--memory and --work-dir only apply to --algorithm external");
+    }
+
+    FinalGraph finalGraph = GraphParser::importFinalGraph(input, inputFormat);
+    // the engine runs on the renumbered graph, its results are mapped back to the edges of the input below
+    std::optional<ReorderedGraph> reordered;
+    if (ordering != NodeOrdering::Input) {
+        reordered = GraphReorderer::reorder(finalGraph, ordering);
+    }
+    FinalGraphView graph = reordered ? reordered->graph.view() : finalGraph.view();
+    ReductionOptions options;
+    options.algorithm = algorithm == "dfs" ? ReductionAlgorithm::DFS : ReductionAlgorithm::TROPlus;
+    options.index = index;
+    options.numberOfThreads = static_cast<unsigned>(numberOfThreads);
+    // 32-bit indices halve the engine's arrays, only graphs beyond their range need the wide engine
+    bool isCertifying = arguments.flags.contains("--certify");
+    EngineResult result = ReductionGraph::fits(finalGraph.numberOfNodes(), finalGraph.numberOfEdges())
+                          ? reduceWith<std::uint32_t>(graph, reordered ? &*reordered : nullptr, options, isCertifying)
+                          : reduceWith<std::uint64_t>(graph, reordered ? &*reordered : nullptr, options, isCertifying);
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start
+                                                        - result.certificationTime;
+
+    if (!output.empty()) {
+        GraphParser::exportReducedGraph(finalGraph.view(), result.redundancyBitmap, output, outputFormat,
+                                        compression);
+    }
+    if (arguments.has("--bitmap")) {
+        GraphParser::exportRedundancyBitmap(result.redundancyBitmap, finalGraph.numberOfEdges(),
+                                            arguments.get("--bitmap", ""), outputFormat);
+    }
+    std::cerr << result.redundantEdges << " of " << finalGraph.numberOfEdges() << " edges redundant, "
+              << elapsed.count() << " ms\n";
+    if (isCertifying) {
+        return reportCertificate(*result.certificate, result.certificationTime);
+    }
+    return Success;
+}
+
+/**
+ * expand a bench argument: a directory stands for its .txt and .bin graph files, anything else is a glob pattern
+ */
+static void expandInput(const std::string &argument, std::vector<std::string> &filePaths) {
+    if (std::filesystem::is_directory(argument)) {
+        std::vector<std::string> directoryFiles;
+        for (const auto &entry: std::filesystem::directory_iterator(argument)) {
+            if (entry.is_regular_file()
+                && (entry.path().extension() == ".txt" || entry.path().extension() == ".bin")) {
+                directoryFiles.push_back(entry.path().string());
+            }
+        }
+        std::sort(directoryFiles.begin(), directoryFiles.end());
+        filePaths.insert(filePaths.end(), directoryFiles.begin(), directoryFiles.end());
+        return;
+    }
+    glob_t matches{};
+    int result = glob(argument.c_str(), 0, nullptr, &matches);
+    if (result == 0) {
+        filePaths.insert(filePaths.end(), matches.gl_pathv, matches.gl_pathv + matches.gl_pathc);
+    }
+    globfree(&matches);
+    if (result != 0) {
+        throw std::runtime_error("No graph files match " + argument);
+    }
+}
+
+static int runBench(const Arguments &arguments) {
+    if (arguments.positional.empty()) {
+        throw UsageException("expected at least one graph file, directory or glob");
+    }
+    BenchmarkConfig config;
+    config.csvFilePath = arguments.get("--csv", config.csvFilePath);
+    config.jsonFilePath = arguments.get("--json", config.jsonFilePath);
+    config.warmupRuns = static_cast<unsigned>(parseNumber(arguments, "--warmup", config.warmupRuns));
+    config.minRuns = static_cast<unsigned>(parseNumber(arguments, "--min-runs", config.minRuns));
+    config.maxRuns = static_cast<unsigned>(parseNumber(arguments, "--max-runs", config.maxRuns));
+    config.targetRelativeConfidence = parseDecimal(arguments, "--confidence", config.targetRelativeConfidence);
+    config.maxSecondsPerGraph = parseDecimal(arguments, "--max-seconds", config.maxSecondsPerGraph);
+    config.phaseRuns = static_cast<unsigned>(parseNumber(arguments, "--phase-runs", config.phaseRuns));
+    config.exportFilePath = arguments.get("--export", config.exportFilePath);
+    config.ordering = parseOrdering(arguments);
+    config.prefaultInputs = !arguments.flags.contains("--no-prefault");
+    config.countHardwareEvents = !arguments.flags.contains("--no-hardware-counters");
+    if (arguments.has("--cpu")) {
+        config.cpu = static_cast<int>(parseNumber(arguments, "--cpu", 0));
+    }
+
+    std::vector<std::string> filePaths;
+    for (const std::string &argument: arguments.positional) {
+        expandInput(argument, filePaths);
+    }
+    std::vector<MeasurementSummary> summaries = TimeMeasurer::startMeasurement(filePaths, config);
+    std::cerr << summaries.size() << " metrics measured on " << filePaths.size() << " graph(s)\n";
+    return Success;
+}
+
+static int runBatch(const Arguments &arguments) {
+    if (arguments.positional.empty()) {
+        throw UsageException("expected at least one graph file, directory or glob");
+    }
+    BatchConfig config;
+    config.algorithm = parseChoice<ReductionAlgorithm>(arguments, "--algorithm", "tro+",
+                                                       {{"dfs",  ReductionAlgorithm::DFS},
+                                                        {"tro+", ReductionAlgorithm::TROPlus}});
+    config.numberOfWorkers = static_cast<unsigned>(parseNumber(arguments, "--workers", config.numberOfWorkers));
+    config.numberOfLoaders = static_cast<unsigned>(parseNumber(arguments, "--loaders", config.numberOfLoaders));
+    config.memoryBudgetBytes = parseNumber(arguments, "--memory", config.memoryBudgetBytes >> 20) << 20;
+    config.outputFilePath = arguments.get("--output", "");
+    config.outputFormat = parseOutputFormat(arguments, "--output-format");
+
+    std::vector<std::string> filePaths;
+    for (const std::string &argument: arguments.positional) {
+        expandInput(argument, filePaths);
+    }
+    BatchResult result = BatchExecutor::run(filePaths, config);
+    std::cerr << result.graphs << " graphs reduced, " << result.failedGraphs << " failed, "
+              << result.redundantEdges << " of " << result.edges << " edges redundant, " << result.seconds
+              << " s, " << result.graphsPerSecond() << " graphs/s\n";
+    return result.failedGraphs == 0 ? Success : Failure;
+}
+
+static int runVerify(const Arguments &arguments) {
+    requirePositional(arguments, 1);
+    const std::string &input = arguments.positional[0];
+    std::string check = arguments.get("--check", "all");
+    if (check != "all" && check != "cross" && check != "topo" && check != "sort" && check != "memory"
+        && check != "certificate") {
+        throw UsageException("invalid value of --check: " + check);
+    }
+    if (arguments.has("--reduced") != (check == "certificate")) {
+        throw UsageException("--check certificate needs --reduced, which only applies to it");
+    }
+    if (arguments.has("--iterations") && check != "memory") {
+        throw UsageException("--iterations only applies to --check memory");
+    }
+    for (const char* option: {"--samples", "--mismatches"}) {
+        if (arguments.has(option) && check != "all" && check != "cross") {
+            throw UsageException(std::string(option) + " only applies to --check cross");
+        }
+    }
+    if (arguments.has("--threads") && check != "all" && check != "cross" && check != "topo"
+        && check != "certificate") {
+        throw UsageException("--threads only applies to --check cross, topo and certificate");
+    }
+    bool isValid = true;
+    auto report = [&isValid](const char* name, bool passed) {
+        std::cout << name << ": " << (passed ? "passed" : "FAILED") << "\n";
+        isValid = isValid && passed;
+    };
+    if (check == "all" || check == "cross") {
+        CrossValidationConfig config;
+        config.numberOfThreads = static_cast<unsigned>(parseNumber(arguments, "--threads", config.numberOfThreads));
+        config.numberOfSamples = parseNumber(arguments, "--samples", config.numberOfSamples);
+        config.maxReportedMismatches = parseNumber(arguments, "--mismatches", config.maxReportedMismatches);
+        CrossValidationResult result = Verifier::crossValidate(
+                GraphParser::importFinalGraph(input, GraphParser::detectGraphFileFormat(input)), config);
+        std::cout << "engines";
+        for (const ReductionOptions &engine: config.engines) {
+            std::cout << " " << Verifier::engineName(engine);
+        }
+        std::cout << ", " << result.numberOfRedundantEdges << " of " << result.numberOfEdges
+                  << " edges redundant, oracle checked " << result.oracleCheckedEdges << " edges"
+                  << (result.isOracleExhaustive ? "" : " (sampled)") << "\n";
+        for (const EdgeMismatch &mismatch: result.mismatches) {
+            std::cout << "  edge " << mismatch.edgeId << " (" << mismatch.startNodeId << " -> "
+                      << mismatch.endNodeId << ") " << (mismatch.isRedundant ? "removed" : "kept") << " by "
+                      << mismatch.engine << ", not by " << mismatch.reference << ", ";
+            if (mismatch.witness.empty()) {
+                std::cout << "no other path\n";
+            } else {
+                std::cout << "other path";
+                for (std::uint64_t node: mismatch.witness) {
+                    std::cout << " " << node;
+                }
+                std::cout << "\n";
+            }
+        }
+        if (result.numberOfMismatches > result.mismatches.size()) {
+            std::cout << "  " << result.numberOfMismatches - result.mismatches.size() << " more mismatches\n";
+        }
+        report("cross check of the engines and the closure oracle", result.isValid());
+    }
+    if (check == "all" || check == "topo") {
+        report("topological order", Verifier::verifyGraphTopoOrder(
+                input, static_cast<unsigned>(parseNumber(arguments, "--threads", 1))));
+    }
+    if (check == "all" || check == "sort") {
+        report("TRO+ edge order", Verifier::verifyEdgesSortingOrder(input));
+    }
+    if (check == "certificate") {
+        CertificateConfig config;
+        config.numberOfThreads = static_cast<unsigned>(parseNumber(arguments, "--threads", config.numberOfThreads));
+        std::string reducedPath = arguments.get("--reduced", "");
+        ReductionCertificate certificate = Verifier::certifyReduction(
+                GraphParser::importFinalGraph(input, GraphParser::detectGraphFileFormat(input)),
+                GraphParser::importFinalGraph(reducedPath, GraphParser::detectGraphFileFormat(reducedPath)), config);
+        printCertificate(certificate);
+        report("reduction certificate", certificate.isValid());
+    }
+    if (check == "memory") {
+        MemoryStabilityResult result = Verifier::checkMemoryStability(
+                input, static_cast<unsigned>(parseNumber(arguments, "--iterations", 1000)));
+        std::cout << "RSS after warmup " << result.rssAfterWarmupKilobytes << " kB, after " << result.iterations
+                  << " iterations " << result.rssAtEndKilobytes << " kB\n";
+        report("memory stability", result.isStable());
+    }
+    return isValid ? Success : VerificationFailed;
+}
+
+static int runFuzz(const Arguments &arguments) {
+    requirePositional(arguments, 0);
+    DifferentialConfig config;
+    config.iterations = parseNumber(arguments, "--iterations", config.iterations);
+    config.seed = parseNumber(arguments, "--seed", config.seed);
+    config.maxNodes = parseNumber(arguments, "--max-nodes", config.maxNodes);
+    config.failureFilePath = arguments.get("--failure", "differential_failure.txt");
+    std::string kernelFailure = DifferentialTester::checkBitKernels(config.seed);
+    if (!kernelFailure.empty()) {
+        std::cout << kernelFailure << "\n";
+        return VerificationFailed;
+    }
+    DifferentialResult result = DifferentialTester::runRandomized(config);
+    std::cout << result.graphs << " graphs with " << result.edges << " edges checked\n";
+    if (!result.isValid()) {
+        const GeneratorConfig &failing = result.failingConfig;
+        std::cout << result.failure << "\n  generated with --model "
+                  << DifferentialTester::modelName(failing.model) << " --nodes " << failing.numberOfNodes << " --edges "
+                  << failing.numberOfEdges << " --depth " << failing.depth << " --seed " << failing.seed
+                  << ", written to " << config.failureFilePath << "\n";
+        return VerificationFailed;
+    }
+    return Success;
+}
+
+static int runPerf(const Arguments &arguments) {
+    requirePositional(arguments, 0);
+    PerformanceConfig config;
+    config.runs = static_cast<unsigned>(parseNumber(arguments, "--runs", config.runs));
+    config.seed = parseNumber(arguments, "--seed", config.seed);
+    // the bit kernels of another level than the best one, to measure what the vector instructions gain
+    if (arguments.has("--kernels")) {
+        BitKernels::setLevel(parseChoice<BitKernelLevel>(arguments, "--kernels", "",
+                                                         {{"scalar", BitKernelLevel::Scalar},
+                                                          {"sse4.2", BitKernelLevel::SSE42},
+                                                          {"avx2",   BitKernelLevel::AVX2},
+                                                          {"avx512", BitKernelLevel::AVX512}}));
+    }
+    std::cout << "bit kernels: " << BitKernels::levelName(BitKernels::level()) << "\n";
+    std::vector<PerformanceSample> samples = DifferentialTester::measurePerformance(config);
+    for (const PerformanceSample &sample: samples) {
+        std::cout << sample.family << " " << sample.numberOfNodes << " nodes " << sample.numberOfEdges << " edges "
+                  << sample.engine << ": " << sample.nanosecondsPerEdge << " ns per edge\n";
+    }
+    if (arguments.has("--csv")) {
+        DifferentialTester::writePerformanceCsv(arguments.get("--csv", ""), samples);
+    }
+    if (!arguments.has("--baseline")) {
+        return Success;
+    }
+    double tolerance = parseDecimal(arguments, "--tolerance", 0.1);
+    std::vector<std::string> regressions = DifferentialTester::findRegressions(
+            samples, arguments.get("--baseline", ""), tolerance);
+    for (const std::string &regression: regressions) {
+        std::cout << "regression: " << regression << "\n";
+    }
+    return regressions.empty() ? Success : VerificationFailed;
+}
+
+static int runConvert(const Arguments &arguments) {
+    requirePositional(arguments, 2);
+    GraphFileFormat inputFormat = parseInputFormat(arguments, "--from", arguments.positional[0]);
+    GraphFileFormat outputFormat = parseOutputFormat(arguments, "--to");
+    OutputCompression compression = parseCompression(arguments);
+    FinalGraph finalGraph = GraphParser::importFinalGraph(arguments.positional[0], inputFormat);
+    if (outputFormat == GraphFileFormat::Binary) {
+        GraphParser::exportFinalGraphBinary(finalGraph, arguments.positional[1], compression);
+    } else {
+        GraphParser::exportFinalGraph(finalGraph, arguments.positional[1], compression);
+    }
+    return Success;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        printUsage();
+        return UsageError;
+    }
+    std::string command = argv[1];
+    try {
+        if (command == "reduce") {
+            return runReduce(parseArguments(argc, argv,
+                                            {"--format", "--algorithm", "--index", "--threads", "--output",
+                                             "--output-format", "--compression", "--bitmap", "--memory",
+                                             "--work-dir", "--order"}, {"--certify"}));
+        } else if (command == "bench") {
+            return runBench(parseArguments(argc, argv,
+                                           {"--csv", "--json", "--warmup", "--min-runs", "--max-runs",
+                                            "--confidence", "--max-seconds", "--cpu", "--phase-runs", "--export",
+                                            "--order"},
+                                           {"--no-prefault", "--no-hardware-counters"}));
+        } else if (command == "batch") {
+            return runBatch(parseArguments(argc, argv,
+                                           {"--output", "--output-format", "--algorithm", "--workers", "--loaders",
+                                            "--memory"}, {}));
+        } else if (command == "verify") {
+            return runVerify(parseArguments(argc, argv, {"--check", "--iterations", "--threads", "--samples",
+                                                         "--mismatches", "--reduced"}, {}));
+        } else if (command == "fuzz") {
+            return runFuzz(parseArguments(argc, argv, {"--iterations", "--seed", "--max-nodes", "--failure"}, {}));
+        } else if (command == "perf") {
+            return runPerf(parseArguments(argc, argv, {"--csv", "--baseline", "--tolerance", "--runs", "--seed",
+                                                       "--kernels"}, {}));
+        } else if (command == "convert") {
+            return runConvert(parseArguments(argc, argv, {"--from", "--to", "--compression"}, {}));
+        } else if (command == "--help" || command == "help") {
+            printUsage();
+            return Success;
+        }
+        throw UsageException("unknown command " + command);
+    } catch (const UsageException &error) {
+        std::cerr << error.what() << "\n";
+        printUsage();
+        return UsageError;
+    } catch (const std::exception &error) {
+        std::cerr << error.what() << "\n";
+        return Failure;
+    }
 }